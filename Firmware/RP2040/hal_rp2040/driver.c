@@ -42,6 +42,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "hardware/i2c.h"
 #include "hardware/gpio.h"
 #include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "hardware/structs/systick.h"
 
 #include "../src/grbl/grbl.h"
@@ -54,6 +55,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 static leds_t leds_state = {
     .value = 255
 };
+static spin_lock_t *uilib_lock;
 
 #if UILIB_KEYPAD_ENABLE
 
@@ -118,6 +120,7 @@ static systick_callbak_ptr systickCallback = NULL;
 
 void hal_init (void)
 {
+    uilib_lock = spin_lock_init(spin_lock_claim_unused(true));
 
 #if UILIB_KEYPAD_ENABLE
 
@@ -225,6 +228,24 @@ uint32_t lcd_systicks (void)
     return systicks;
 }
 
+/*
+ * UILib event queue, producers are the navigator, keypad and touch interrupt handlers
+ */
+uint32_t UILibCriticalEnter (void)
+{
+    return spin_lock_blocking(uilib_lock);
+}
+
+void UILibCriticalExit (uint32_t state)
+{
+    spin_unlock(uilib_lock, state);
+}
+
+uint32_t UILibGetTimestamp (void)
+{
+    return time_us_32();
+}
+
 /*
  * long delay
  */
@@ -44,6 +44,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
+#include "hardware/dma.h"
 
 #include "../src/LCD/graphics.h"
 
@@ -55,7 +56,15 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define F_TOUCH     150000
 #define F_TOUCH_CAL 50000
 
+#ifndef LCD_DMA_MIN_PIXELS
+#define LCD_DMA_MIN_PIXELS 8 // shorter runs are pushed by the CPU, DMA setup costs more than it saves
+#endif
+
 static lcd_driver_t *driver;
+static int dma_tx;
+static volatile bool dma_active = false;
+static bool frame16 = false;
+static uint16_t dma_fill; // colour word read repeatedly by the DMA channel for fills, must not change while active
 
 inline static uint8_t readByte (uint8_t cmd)
 {
@@ -66,37 +75,104 @@ inline static uint8_t readByte (uint8_t cmd)
     return buf;
 }
 
-void lcd_writePixels (uint16_t *pixels, uint32_t length)
+// Switch PL022 frame size, commands and parameters are sent as 8 bit frames,
+// coordinates and RGB565 pixel data as 16 bit frames. Bus must be idle.
+inline static void setFrameSize (bool wide)
+{
+    if(frame16 != wide) {
+        frame16 = wide;
+        spi_set_format(SPI_PORT, wide ? 16 : 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    }
+}
+
+// Start a background pixel burst, CS is held asserted until lcd_busyWait() is called.
+static void dma_start (const volatile void *data, uint32_t length, bool increment)
 {
+    dma_channel_config cfg = dma_channel_get_default_config(dma_tx);
+
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, increment);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, spi_get_dreq(SPI_PORT, true));
+
     LCD_SELECT;
 
-    uint8_t *data = (uint8_t *)pixels;
+    dma_active = true;
+    dma_channel_configure(dma_tx, &cfg, &spi_get_hw(SPI_PORT)->dr, data, length, true);
+}
+
+// Completion fence: waits for any pixel burst in progress to finish, then releases the bus.
+void lcd_busyWait (void)
+{
+    if(dma_active) {
+
+        dma_channel_wait_for_finish_blocking(dma_tx);
+
+        while(spi_is_busy(SPI_PORT));
+
+        // Drain RX FIFO and clear the overrun flag raised while transmitting only
+        while(spi_is_readable(SPI_PORT))
+            (void)spi_get_hw(SPI_PORT)->dr;
+        spi_get_hw(SPI_PORT)->icr = SPI_SSPICR_RORIC_BITS;
 
-    while(length--) {
-        spi_write_blocking(SPI_PORT, data + 1, 1);
-        spi_write_blocking(SPI_PORT, data, 1);
-        data += 2;
-   //     SPI_DR = *pixels & 0xFF;
-   //     SPI_DR = *pixels++ >> 8;
+        LCD_DESELECT;
+
+        dma_active = false;
     }
+}
 
-    LCD_DESELECT;
+// Pixel data is in RGB565 format, transfer is completed before returning since
+// the caller is free to reuse the buffer.
+void lcd_writePixels (uint16_t *pixels, uint32_t length)
+{
+    lcd_busyWait();
+    setFrameSize(true);
+
+    if(length >= LCD_DMA_MIN_PIXELS) {
+        dma_start(pixels, length, true);
+        lcd_busyWait();
+    } else {
+        LCD_SELECT;
+        spi_write16_blocking(SPI_PORT, pixels, length);
+        LCD_DESELECT;
+    }
 }
 
+// Fills run in the background, the next command sent to the panel waits for completion.
 void lcd_writePixel (colorRGB565 color, uint32_t count)
 {
+    lcd_busyWait();
+    setFrameSize(true);
+
+    dma_fill = ((uint16_t)color.lowByte << 8) | color.highByte;
+
+    if(count >= LCD_DMA_MIN_PIXELS)
+        dma_start(&dma_fill, count, false);
+    else {
+        LCD_SELECT;
+        while(count--)
+            spi_write16_blocking(SPI_PORT, &dma_fill, 1);
+        LCD_DESELECT;
+    }
+}
+
+void lcd_writeData16 (uint16_t data)
+{
+    lcd_busyWait();
+    setFrameSize(true);
+
     LCD_SELECT;
 
-    while(count--) {
-        spi_write_blocking(SPI_PORT, &color.lowByte, 1);
-        spi_write_blocking(SPI_PORT, &color.highByte, 1);
-    }
+    spi_write16_blocking(SPI_PORT, &data, 1);
 
     LCD_DESELECT;
 }
 
 void lcd_writeData (uint8_t data)
 {
+    lcd_busyWait();
+    setFrameSize(false);
+
     LCD_SELECT;
 
     spi_write_blocking(SPI_PORT, &data, 1);
@@ -106,6 +182,9 @@ void lcd_writeData (uint8_t data)
 
 void lcd_writeCommand (uint8_t command)
 {
+    lcd_busyWait();
+    setFrameSize(false);
+
     LCD_SELECT;
     LCD_DC_CMD;
 
@@ -184,6 +263,25 @@ static void TouchIntHandler (void)
 
 #endif
 
+#ifdef LCD_FILL_BENCHMARK
+
+// Times full panel fills as done by clearScreen(), including completion of the transfer.
+// Returns the average duration of a fill in microseconds.
+uint32_t lcd_fillBenchmark (uint_fast8_t passes)
+{
+    uint_fast8_t pass = passes;
+    uint32_t elapsed = time_us_32();
+
+    while(pass--) {
+        clearScreen(pass & 1);
+        lcd_busyWait();
+    }
+
+    return (time_us_32() - elapsed) / passes;
+}
+
+#endif
+
 /* MCU peripherals init */
 
 void lcd_driverInit (lcd_driver_t *drv)
@@ -213,6 +311,8 @@ void lcd_driverInit (lcd_driver_t *drv)
     LCD_DESELECT;
     LCD_DC_DATA;
 
+    dma_tx = dma_claim_unused_channel(true);
+
 #ifdef TOUCH_CS_PORT
     MAP_GPIOPinTypeGPIOOutput(TOUCH_CS_PORT, TOUCH_CS_PIN);
     TOUCH_DESELECT;
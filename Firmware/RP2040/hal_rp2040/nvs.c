@@ -0,0 +1,92 @@
+/*
+ * nvs.c - HAL non-volatile storage for Raspberry RP2040 ARM processor
+ *
+ * Part of MPG/DRO for grbl on a secondary processor
+ *
+ * v0.0.1 / 2026-10-16 / (c) Io Engineering / Terje
+ */
+
+/*
+
+Copyright (c) 2026, Terje Io
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its contributors may
+be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+
+#include "../src/interface.h"
+
+// The last sector of flash is used, well above the program image
+#define NVS_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define NVS_SIZE FLASH_SECTOR_SIZE
+
+bool nvs_read (void *data, size_t size)
+{
+    if(size > NVS_SIZE)
+        return false;
+
+    memcpy(data, (const void *)(XIP_BASE + NVS_OFFSET), size);
+
+    return true;
+}
+
+// Interrupts are disabled while the sector is erased and programmed since code
+// cannot execute from flash meanwhile, this blocks for some tens of milliseconds.
+// Called by grblStoreSnapshot() when idle, never while serial data is handled.
+bool nvs_write (const void *data, size_t size)
+{
+    static uint8_t page[FLASH_PAGE_SIZE];
+
+    uint32_t state;
+    size_t offset = size & ~(FLASH_PAGE_SIZE - 1);
+
+    if(size > NVS_SIZE)
+        return false;
+
+    state = save_and_disable_interrupts();
+
+    flash_range_erase(NVS_OFFSET, FLASH_SECTOR_SIZE);
+
+    if(offset)
+        flash_range_program(NVS_OFFSET, (const uint8_t *)data, offset);
+
+    if(offset < size) {
+        memset(page, 0xFF, sizeof(page));
+        memcpy(page, (const uint8_t *)data + offset, size - offset);
+        flash_range_program(NVS_OFFSET + offset, page, FLASH_PAGE_SIZE);
+    }
+
+    restore_interrupts(state);
+
+    return true;
+}
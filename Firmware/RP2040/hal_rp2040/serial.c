@@ -43,6 +43,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "hardware/gpio.h"
 #include "hardware/uart.h"
 #include "hardware/irq.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
 
 #include "../src/interface.h"
 
@@ -52,22 +54,61 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define UART ((uart_hw_t *)UART_PORT)
 
-#define BUFNEXT(ptr, buffer) ((ptr + 1) & (sizeof(buffer.data) - 1))
-#define BUFCOUNT(head, tail, size) ((head >= tail) ? (head - tail) : (size - tail + head))
-#define STREAM_BUFFER_SIZE 512
+#define RX_DMA_RING_BITS 10
+#define RX_DMA_BUFFER_SIZE (1 << RX_DMA_RING_BITS)
+#define RX_DMA_TRANSFERS 0x80000000UL   // channel is rearmed after this many bytes, a multiple of the buffer size
+#define RX_LINES_MAX 32                 // must be a power of 2
+#define TX_QUEUE_SIZE 32                // must be a power of 2
+#define TX_RT_SIZE 8                    // real-time commands pending while a transfer is in progress
+#define TX_DMA_IRQ DMA_IRQ_1
 
+// Received data is written to rx_data by a DMA channel in ring mode. Positions are free running
+// byte counts, the index into rx_data is the position modulo the buffer size.
 typedef struct {
-    volatile uint_fast16_t head;
-    volatile uint_fast16_t tail;
+    int channel;
+    uint32_t base;                      // position where the current DMA transfer started
+    uint32_t head;                      // received, as published by rxPublish()
+    uint32_t tail;                      // consumed
+    uint32_t scanned;                   // searched for line ends
     bool overflow;
-    char data[STREAM_BUFFER_SIZE];
-} stream_buffer_t;
+    bool cancel;                        // return ASCII_CAN before any more data
+    uint_fast8_t line_head, line_tail;
+    uint32_t line_end[RX_LINES_MAX];    // positions of the line feeds not yet consumed
+} rx_dma_t;
 
-static uint16_t tx_fifo_size;
-static stream_buffer_t txbuffer = {0};
-static stream_buffer_t rxbuffer = {0};
-
-static void uart_interrupt_handler (void);
+typedef struct {
+    const char *data;
+    uint16_t length;
+    uint16_t release;                   // bytes of tx_data freed when sent
+} tx_descriptor_t;
+
+// Data to transmit is queued as descriptors referencing either the callers buffers, which must
+// be left untouched until sent, or copies in tx_data. They are sent in turn by a DMA channel.
+// Real-time commands are sent by the same channel ahead of the next descriptor, they are
+// collected in one buffer while the other is being sent.
+typedef struct {
+    int channel;
+    volatile uint_fast8_t head;
+    volatile uint_fast8_t tail;         // descriptor being sent when busy and not sending real-time commands
+    volatile bool busy;
+    volatile uint32_t done;             // number of descriptors sent
+    uint32_t queued;                    // number of descriptors queued
+    uint32_t data_head;                 // tx_data allocated, free running
+    volatile uint32_t data_tail;        // tx_data released, free running
+    volatile bool rt_busy;              // sending real-time commands
+    uint_fast8_t rt_fill;               // real-time buffer being filled
+    volatile uint_fast8_t rt_count;     // real-time commands in it
+    char rt[2][TX_RT_SIZE];
+    tx_descriptor_t queue[TX_QUEUE_SIZE];
+} tx_dma_t;
+
+static serial_counters_t counters = {0};
+static rx_dma_t rx = {0};
+static tx_dma_t tx = {0};
+static char rx_data[RX_DMA_BUFFER_SIZE] __attribute__((aligned(RX_DMA_BUFFER_SIZE)));
+static char tx_data[TX_BUFFER_SIZE];
+
+static void tx_dma_interrupt_handler (void);
 
 void serial_init (void)
 {
@@ -78,13 +119,36 @@ void serial_init (void)
 
     uart_set_hw_flow(UART_PORT, false, false);
     uart_set_format(UART_PORT, 8, 1, UART_PARITY_NONE);
-    uart_set_baudrate(UART_PORT, 115200);
+    uart_set_baudrate(UART_PORT, SERIAL_BAUD_RATE);
     uart_set_fifo_enabled(UART_PORT, true);
 
-    irq_set_exclusive_handler(UART_IRQ, uart_interrupt_handler);
-    irq_set_enabled(UART_IRQ, true);
-    
-    hw_set_bits(&UART->imsc, UART_UARTIMSC_RXIM_BITS|UART_UARTIMSC_RTIM_BITS);             
+    // RX is handled by DMA without interrupts, uart_init() has enabled the DMA requests
+    rx.channel = dma_claim_unused_channel(true);
+
+    dma_channel_config cfg = dma_channel_get_default_config(rx.channel);
+
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_ring(&cfg, true, RX_DMA_RING_BITS);
+    channel_config_set_dreq(&cfg, uart_get_dreq(UART_PORT, false));
+
+    dma_channel_configure(rx.channel, &cfg, rx_data, &UART->dr, RX_DMA_TRANSFERS, true);
+
+    tx.channel = dma_claim_unused_channel(true);
+
+    cfg = dma_channel_get_default_config(tx.channel);
+
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, uart_get_dreq(UART_PORT, true));
+
+    dma_channel_configure(tx.channel, &cfg, &UART->dr, NULL, 0, false);
+    dma_channel_set_irq1_enabled(tx.channel, true);
+
+    irq_set_exclusive_handler(TX_DMA_IRQ, tx_dma_interrupt_handler);
+    irq_set_enabled(TX_DMA_IRQ, true);
 }
 
 static bool serialBlockingCallbackDummy (void)
@@ -106,6 +170,57 @@ void setSerialReceiveCallback (bool (*fn)(char))
  //   serialReceiveCallback = fn;
 }
 
+// Brings the head up to date with the DMA transfer count and indexes the line ends received.
+// Called from the consumer side only, the DMA channel is the single producer.
+static void rxPublish (void)
+{
+    uint32_t remaining = dma_channel_hw_addr(rx.channel)->transfer_count;
+
+    if(remaining == 0 && !dma_channel_is_busy(rx.channel)) {
+        rx.base += RX_DMA_TRANSFERS;
+        dma_channel_set_trans_count(rx.channel, RX_DMA_TRANSFERS, true);
+        remaining = RX_DMA_TRANSFERS;
+    }
+
+    rx.head = rx.base + (RX_DMA_TRANSFERS - remaining);
+
+    if(UART->ris & UART_UARTRIS_FERIS_BITS) { // most likely SERIAL_BAUD_RATE does not match the controller
+        UART->icr = UART_UARTICR_FEIC_BITS;
+        counters.framing_errors++;
+    }
+
+    if(rx.head - rx.tail > RX_DMA_BUFFER_SIZE) { // unread data was overwritten, drop all of it
+        rx.overflow = rx.cancel = true;
+        counters.overflows++;
+        rx.tail = rx.scanned = rx.head;
+        rx.line_tail = rx.line_head;
+    }
+
+    while(rx.scanned != rx.head && ((rx.line_head + 1) & (RX_LINES_MAX - 1)) != rx.line_tail) {
+
+        uint32_t idx = rx.scanned & (RX_DMA_BUFFER_SIZE - 1), span = rx.head - rx.scanned;
+        char *eol;
+
+        if(span > RX_DMA_BUFFER_SIZE - idx)
+            span = RX_DMA_BUFFER_SIZE - idx;
+
+        if((eol = memchr(&rx_data[idx], ASCII_LF, span))) {
+            rx.scanned += eol - &rx_data[idx];
+            rx.line_end[rx.line_head] = rx.scanned++;
+            rx.line_head = (rx.line_head + 1) & (RX_LINES_MAX - 1);
+            counters.lines_in++;
+        } else
+            rx.scanned += span;
+    }
+}
+
+// Drops line index entries for lines already consumed by serial_getC()
+static inline void rxDropLines (void)
+{
+    while(rx.line_tail != rx.line_head && (int32_t)(rx.line_end[rx.line_tail] - rx.tail) < 0)
+        rx.line_tail = (rx.line_tail + 1) & (RX_LINES_MAX - 1);
+}
+
 //
 // serialGetC - returns -1 if no data available
 //
@@ -113,64 +228,242 @@ void setSerialReceiveCallback (bool (*fn)(char))
 int16_t serial_getC (void)
 {
     int16_t data;
-    uint_fast16_t bptr = rxbuffer.tail;
 
-    if(bptr == rxbuffer.head)
+    if(rx.tail == rx.head)
+        rxPublish();
+
+    if(rx.cancel) {
+        rx.cancel = false;
+        return ASCII_CAN;
+    }
+
+    if(rx.tail == rx.head)
         return -1; // no data available else EOF
 
-    data = rxbuffer.data[bptr];                 // Get next character, increment tmp pointer
-    rxbuffer.tail = BUFNEXT(bptr, rxbuffer);    // and update pointer
+    data = rx_data[rx.tail++ & (RX_DMA_BUFFER_SIZE - 1)];
+
+    rxDropLines();
 
     return data;
 }
 
-inline static uint16_t serialRxCount (void)
+//
+// serial_getLn - copies the next complete line, without terminators, to line.
+// Returns the length copied or -1 if no complete line is available.
+// Lines longer than size - 1 are truncated.
+//
+
+int16_t serial_getLn (char *line, uint_fast16_t size)
 {
-    uint_fast16_t head = rxbuffer.head, tail = rxbuffer.tail;
+    uint32_t end, idx, length, span;
+
+    if(rx.cancel)
+        return -1;
+
+    rxPublish();
+    rxDropLines();
+
+    if(rx.cancel || rx.line_tail == rx.line_head)
+        return -1;
+
+    end = rx.line_end[rx.line_tail];
+    rx.line_tail = (rx.line_tail + 1) & (RX_LINES_MAX - 1);
+
+    if((length = end - rx.tail) > size - 1)
+        length = size - 1;
+
+    idx = rx.tail & (RX_DMA_BUFFER_SIZE - 1);
+    span = length > RX_DMA_BUFFER_SIZE - idx ? RX_DMA_BUFFER_SIZE - idx : length;
+
+    memcpy(line, &rx_data[idx], span);
+    memcpy(line + span, rx_data, length - span);
 
-    return BUFCOUNT(head, tail, RX_BUFFER_SIZE);
+    if(length && line[length - 1] == ASCII_CR)
+        length--;
+
+    line[length] = '\0';
+    rx.tail = end + 1;
+
+    return (int16_t)length;
+}
+
+inline static uint16_t serialRxCount (void)
+{
+    return (uint16_t)(rx.head - rx.tail);
 }
 
 uint16_t static serialRxFree (void)
 {
-    return STREAM_BUFFER_SIZE - 1 - serialRxCount();
+    return RX_DMA_BUFFER_SIZE - serialRxCount();
 }
 
 void serialRxFlush (void)
 {
-    rxbuffer.tail = rxbuffer.head;
-    rxbuffer.overflow = false;
+    rxPublish();
+    rx.tail = rx.scanned = rx.head;
+    rx.line_tail = rx.line_head;
+    rx.overflow = false;
 }
 
 void serial_RxCancel (void)
 {
     serialRxFlush();
-    rxbuffer.data[rxbuffer.head] = ASCII_CAN;
-    rxbuffer.head = BUFNEXT(rxbuffer.head, rxbuffer);
+    rx.cancel = true;
 }
 
-void serial_writeS (const char *data)
+// Bytes received is the free running head position, the other counters are updated as events occur
+const serial_counters_t *serial_getCounters (void)
+{
+    rxPublish();
+
+    counters.bytes_in = rx.head;
+
+    return &counters;
+}
+
+// Starts sending pending real-time commands or else the next descriptor if the channel is idle,
+// interrupts must be disabled
+static void txStart (void)
+{
+    if(tx.busy)
+        return;
+
+    if(tx.rt_count) {
+        tx.busy = tx.rt_busy = true;
+        dma_channel_transfer_from_buffer_now(tx.channel, tx.rt[tx.rt_fill], tx.rt_count);
+        tx.rt_fill ^= 1;
+        tx.rt_count = 0;
+    } else if(tx.tail != tx.head) {
+        tx.busy = true;
+        dma_channel_transfer_from_buffer_now(tx.channel, tx.queue[tx.tail].data, tx.queue[tx.tail].length);
+    }
+}
+
+// Queues data for transmission, returns the number of descriptors queued including it or 0 if the queue is full
+static uint32_t txQueue (const char *data, uint_fast16_t length, uint_fast16_t release)
+{
+    uint32_t irq;
+    uint_fast8_t next = (tx.head + 1) & (TX_QUEUE_SIZE - 1);
+
+    if(length == 0)
+        return tx.queued;
+
+    if(next == tx.tail)
+        return 0;
+
+    tx.queue[tx.head].data = data;
+    tx.queue[tx.head].length = (uint16_t)length;
+    tx.queue[tx.head].release = (uint16_t)release;
+
+    counters.bytes_out += length;
+
+    irq = save_and_disable_interrupts();
+    tx.head = next;
+    txStart();
+    restore_interrupts(irq);
+
+    return ++tx.queued;
+}
+
+// Waits for space in the queue, then for the data queued to be sent
+static void txBlocking (const char *data, uint_fast16_t length)
 {
-    char c, *ptr = (char *)data;
+    uint32_t ticket;
 
-    while((c = *ptr++) != '\0')
-        serial_putC(c);
+    if(length == 0)
+        return;
 
+    while(!(ticket = txQueue(data, length, 0)));
+
+    while((int32_t)(tx.done - ticket) < 0);
+}
+
+// Copies data, and the line terminator if eol is set, to tx_data and queues it. Only waits if the
+// queue or tx_data is full, data that does not fit in tx_data at all is sent from the callers buffer.
+static void txCopy (const char *data, uint_fast16_t length, bool eol)
+{
+    char *copy;
+    uint_fast16_t size = length + (eol ? 2 : 0), skip, idx = tx.data_head & (TX_BUFFER_SIZE - 1);
+
+    if(size == 0)
+        return;
+
+    if(size > TX_BUFFER_SIZE) {
+        txBlocking(data, length);
+        if(eol)
+            txBlocking(ASCII_EOL, 2);
+        return;
+    }
+
+    skip = idx + size > TX_BUFFER_SIZE ? TX_BUFFER_SIZE - idx : 0; // copies are not wrapped
+
+    while(((tx.tail - tx.head - 1) & (TX_QUEUE_SIZE - 1)) == 0 || tx.data_head + skip + size - tx.data_tail > TX_BUFFER_SIZE);
+
+    copy = &tx_data[(idx + skip) & (TX_BUFFER_SIZE - 1)];
+    memcpy(copy, data, length);
+    if(eol)
+        memcpy(copy + length, ASCII_EOL, 2);
+
+    tx.data_head += skip + size;
+
+    txQueue(copy, size, skip + size);
+}
+
+void serial_writeS (const char *data)
+{
+    txCopy(data, strlen(data), false);
 }
 
 void serial_writeLn (const char *data)
 {
-    serial_writeS(data);
-    serial_writeS(ASCII_EOL);
+    txCopy(data, strlen(data), true);
 }
 
 void serial_write (const char *data, unsigned int length)
 {
-    char *ptr = (char *)data;
+    txCopy(data, length, false);
+}
 
-    while(length--)
-        serial_putC(*ptr++);
+//
+// serial_sendLn - queues a line without copying it, the line terminator is added.
+// Blocking calls return when the line has been sent and data may be reused.
+// Otherwise data must be left untouched until serial_txBusy(data) returns false,
+// false is returned if there is no room in the queue for the line.
+//
+
+bool serial_sendLn (const char *data, bool blocking)
+{
+    uint32_t ticket;
 
+    // Both descriptors have to fit so the line is not split
+    while(((tx.tail - tx.head - 1) & (TX_QUEUE_SIZE - 1)) < 2) {
+        if(!blocking) {
+            counters.tx_drops++;
+            return false;
+        }
+    }
+
+    ticket = txQueue(data, strlen(data), 0);
+    txQueue(ASCII_EOL, 2, 0);
+
+    if(blocking)
+        while((int32_t)(tx.done - ticket) < 0);
+
+    return true;
+}
+
+// Returns true while data is queued or being sent
+bool serial_txBusy (const char *data)
+{
+    bool busy = false;
+    uint_fast8_t idx = tx.tail;
+
+    while(!busy && idx != tx.head) {
+        busy = tx.queue[idx].data == data;
+        idx = (idx + 1) & (TX_QUEUE_SIZE - 1);
+    }
+
+    return busy;
 }
 
 #ifdef LINE_BUFFER_SIZE
@@ -200,83 +493,59 @@ char *serialReadLn (void) {
 }
 #endif
 
+// Single characters, typically real-time commands, are sent ahead of queued data as soon as
+// the transfer in progress completes. They are never written to the TX FIFO directly since the
+// DMA channel may fill it between checking for room and writing.
 bool serial_putC (const char c)
 {
-    uint_fast16_t next_head;
-
-    if(!(UART->imsc & UART_UARTIMSC_TXIM_BITS)) {                   // If the transmit interrupt is deactivated
-        if(!(UART->fr & UART_UARTFR_TXFF_BITS)) {                   // and if the TX FIFO is not full
-            UART->dr = c;                                           // Write data in the TX FIFO
-            return true;
-        } else
-            hw_set_bits(&UART->imsc, UART_UARTIMSC_TXIM_BITS);      // Enable transmit interrupt
-    }
-
-    // Write data in the Buffer is transmit interrupt activated or TX FIFO is                                                                
-    next_head = BUFNEXT(txbuffer.head, txbuffer);  // Get and update head pointer
+    bool ok;
+    uint32_t irq = save_and_disable_interrupts();
 
-    while(txbuffer.tail == next_head) {                             // Buffer full, block until space is available...
-   //     if(!hal.stream_blocking_callback())
-            return false;
-    }
+    if((ok = tx.rt_count < TX_RT_SIZE)) {
+        tx.rt[tx.rt_fill][tx.rt_count++] = c;
+        counters.bytes_out++;
+        txStart();
+    } else
+        counters.tx_drops++;
 
-    txbuffer.data[txbuffer.head] = c;                               // Add data to buffer
-    txbuffer.head = next_head;                                      // and update head pointer
+    restore_interrupts(irq);
 
-    return true;
+    return ok;
 }
 
-uint16_t serialTxCount(void)
+uint16_t serialTxCount (void)
 {
-    uint_fast16_t head = txbuffer.head, tail = txbuffer.tail;
-
-    return BUFCOUNT(head, tail, TX_BUFFER_SIZE) + ((UART->fr & UART_UARTFR_BUSY_BITS) ? 0 : 1);
-
-}
+    uint16_t count = 0;
+    uint_fast8_t idx = tx.tail;
 
-static void uart_interrupt_handler (void)
-{
-    uint_fast16_t bptr;
-    uint32_t data, ctrl = UART->mis;
-
-    if(ctrl & (UART_UARTMIS_RXMIS_BITS | UART_UARTIMSC_RTIM_BITS)) {
-
-        while (uart_is_readable(UART_PORT)) {
-
-            bptr = BUFNEXT(rxbuffer.head, rxbuffer);  // Get next head pointer
-            data = UART->dr & 0xFF;                             // and read input (use only 8 bits of data)
-
-            if(bptr == rxbuffer.tail) {                         // If buffer full
-                rxbuffer.overflow = true;                       // flag overflow
-            } else {
-#if MODBUS_ENABLE
-                rxbuffer.data[rxbuffer.head] = (char)data;  // Add data to buffer
-                rxbuffer.head = bptr;                       // and update pointer
-#else
-            //    iif(!hal.stream.enqueue_realtime_command((char)data)) {
-                    rxbuffer.data[rxbuffer.head] = (char)data;  // Add data to buffer
-                    rxbuffer.head = bptr;                       // and update pointer
-             //   }
-#endif
-            }
-        }
+    if(tx.busy) {
+        count = (uint16_t)dma_channel_hw_addr(tx.channel)->transfer_count;
+        if(!tx.rt_busy)
+            idx = (idx + 1) & (TX_QUEUE_SIZE - 1);
     }
 
-    // Interrupt if the TX FIFO is lower or equal to the empty TX FIFO threshold
-    if(ctrl & UART_UARTMIS_TXMIS_BITS)
-    {
-        bptr = txbuffer.tail;
+    count += tx.rt_count;
 
-        // As long as the TX FIFO is not full or the buffer is not empty
-        while((!(UART->fr & UART_UARTFR_TXFF_BITS)) && (txbuffer.head != bptr)) {
-            UART->dr = txbuffer.data[bptr];                         // Put character in TX FIFO
-            bptr = BUFNEXT(bptr, txbuffer);        // and update tmp tail pointer
-        }
+    while(idx != tx.head) {
+        count += tx.queue[idx].length;
+        idx = (idx + 1) & (TX_QUEUE_SIZE - 1);
+    }
 
-        txbuffer.tail = bptr;                                       //  Update tail pointer
+    return count + ((UART->fr & UART_UARTFR_BUSY_BITS) ? 1 : 0);
+}
 
-        if(txbuffer.tail == txbuffer.head)						    // Disable TX interrupt when the TX buffer is empty
-            hw_clear_bits(&UART->imsc, UART_UARTIMSC_TXIM_BITS);
+static void tx_dma_interrupt_handler (void)
+{
+    dma_channel_acknowledge_irq1(tx.channel);
+
+    if(tx.rt_busy)
+        tx.rt_busy = false;
+    else {
+        tx.data_tail += tx.queue[tx.tail].release;
+        tx.tail = (tx.tail + 1) & (TX_QUEUE_SIZE - 1);
+        tx.done++;
     }
+    tx.busy = false;
 
+    txStart();
 }
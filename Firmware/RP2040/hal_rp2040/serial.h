@@ -61,10 +61,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define XONOK (ASCII_XON|0x80)
 #define XOFFOK (ASCII_XOFF|0x80)
-#define TX_BUFFER_SIZE 128      // must be a power of 2
+#define TX_BUFFER_SIZE 1024     // must be a power of 2, lines are copied here by serial_writeLn()
 #define RX_BUFFER_SIZE 1024     // must be a power of 2
 #define RX_BUFFER_HWM 900
 #define RX_BUFFER_LWM 300
+#ifndef SERIAL_BAUD_RATE
+#define SERIAL_BAUD_RATE 115200 // must match the rate of the controller's MPG/display serial port
+#endif
 //#define LINE_BUFFER_SIZE 20
 #define RTS_PIN  GPIO_PIN_4
 //#define RTS_PORT GPIO_PORTF_BASE
@@ -0,0 +1,198 @@
+/*
+ * host/font_bench.c - times rendering of a DRO row with and without the glyph offset index
+ *
+ * part of MPG/DRO for grbl on a secondary processor
+ *
+ * v0.0.1 / 2026-10-16 / (c)Io Engineering / Terje
+ */
+
+/*
+
+Copyright (c) 2026, Terje Io
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its contributors may
+be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/*
+ * Usage: font_bench [passes]
+ *
+ * Renders the position rows of the DRO canvas glyph by glyph, as done by the DRO, with glyphs located
+ * through the offset index and through the linear getoffset() walk the index replaced. The panel
+ * is stubbed out, pixel data is only checksummed so the time is dominated by glyph lookup and
+ * expansion. Fails if the two methods do not produce the same pixels.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Built with graphics.c to reach its glyph index, the fallback is forced by filling the index table
+#include "../src/LCD/graphics.c"
+#include "../src/fonts/arial_48x55.h"
+#include "../src/fonts/font_23x16.h"
+
+#define POSFONT font_arial_48x55
+#define POSCOL 50
+#define XROW 82
+#define ROWSPACING 45
+
+static const char *rows[] = { "-1234.567", "12.340", "-88.008" };
+static uint32_t checksum;
+
+/*
+ * Stubs for the panel driver used by graphics.c
+ *
+ */
+
+void lcd_setArea (uint16_t xStart, uint16_t yStart, uint16_t xEnd, uint16_t yEnd)
+{
+    checksum = checksum * 31 + (((uint32_t)xStart << 16) | yStart) + (((uint32_t)xEnd << 16) | yEnd);
+}
+
+void lcd_writePixel (colorRGB565 color, uint32_t count)
+{
+    checksum = checksum * 31 + count;
+}
+
+void lcd_writePixels (uint16_t *pixels, uint32_t length)
+{
+    while(length--)
+        checksum = checksum * 31 + *pixels++;
+}
+
+void lcd_panelInit (lcd_driver_t *driver) {}
+void lcd_displayOn (bool on) {}
+void lcd_changeOrientation (orientation_t orientation) {}
+void lcd_delayms (uint16_t ms) {}
+void delayms_attach (systick_callbak_ptr callback) {}
+
+/*
+ * Benchmark
+ *
+ */
+
+static uint64_t now (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Disables the index by occupying every slot with another font, drawChar() then falls back to getoffset()
+static void useLinearSearch (void)
+{
+    uint_fast8_t idx;
+
+    for(idx = 0; idx < FONT_INDEX_SIZE; idx++)
+        fontIndex[idx].font = font_23x16;
+
+    lastIndex = NULL;
+}
+
+// Times only the glyph lookup done by drawChar() for the same rows
+static uint64_t lookup (uint32_t passes, bool indexed)
+{
+    static volatile uint16_t offset;
+
+    const char *c;
+    uint_fast8_t row;
+    Font *font = POSFONT;
+    font_index_t *index = getFontIndex(font);
+    uint64_t start = now();
+
+    while(passes--) {
+        for(row = 0; row < sizeof(rows) / sizeof(rows[0]); row++) {
+            for(c = rows[row]; *c; c++)
+                offset = indexed ? index->offset[(uint8_t)*c - font->firstChar] : getoffset(font, (uint8_t)*c);
+        }
+    }
+
+    return now() - start;
+}
+
+static uint64_t render (uint32_t passes, uint32_t *sum)
+{
+    const char *c;
+    uint16_t x;
+    uint_fast8_t row;
+    uint64_t start = now();
+
+    checksum = 0;
+
+    while(passes--) {
+        for(row = 0; row < sizeof(rows) / sizeof(rows[0]); row++) {
+            x = POSCOL;
+            for(c = rows[row]; *c; c++)
+                x += drawChar(POSFONT, x, XROW + row * ROWSPACING, *c, true);
+        }
+    }
+
+    *sum = checksum;
+
+    return now() - start;
+}
+
+int main (int argc, char **argv)
+{
+    uint32_t passes = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000, indexed_sum, linear_sum;
+    uint64_t indexed, linear, indexed_lookup, linear_lookup;
+    uint_fast16_t glyphs = 0;
+    uint_fast8_t row;
+
+    if(passes == 0)
+        passes = 1;
+
+    for(row = 0; row < sizeof(rows) / sizeof(rows[0]); row++)
+        glyphs += strlen(rows[row]);
+
+    setColor(White);
+    setBackgroundColor(Black);
+
+    render(1, &indexed_sum); // builds the index
+    indexed = render(passes, &indexed_sum);
+    indexed_lookup = lookup(passes, true);
+    linear_lookup = lookup(passes, false);
+
+    useLinearSearch();
+    render(1, &linear_sum);
+    linear = render(passes, &linear_sum);
+
+    printf("%lu passes, %lu glyphs per pass\n", (unsigned long)passes, (unsigned long)glyphs);
+    printf("  index:  %.0f ns per row, %.0f ns per glyph\n", (double)indexed / (passes * 3), (double)indexed / (passes * glyphs));
+    printf("  linear: %.0f ns per row, %.0f ns per glyph\n", (double)linear / (passes * 3), (double)linear / (passes * glyphs));
+    printf("  lookup only: index %.1f ns, linear %.1f ns per glyph\n", (double)indexed_lookup / (passes * glyphs), (double)linear_lookup / (passes * glyphs));
+
+    if(indexed_sum != linear_sum) {
+        printf("pixel data differs: %08lx %08lx\n", (unsigned long)indexed_sum, (unsigned long)linear_sum);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,622 @@
+/*
+ * host/replay.c - replays recorded grbl sessions through the parser on a Linux host
+ *
+ * part of MPG/DRO for grbl on a secondary processor
+ *
+ * v0.0.1 / 2026-10-16 / (c)Io Engineering / Terje
+ */
+
+/*
+
+Copyright (c) 2026, Terje Io
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its contributors may
+be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/*
+ * Usage: replay [-l] [-v] capture...         replays captures and checks the expectations in them
+ *        replay -b <passes> capture...       reports parse throughput and per field cost
+ *
+ * -l feeds the parser whole lines through serial_getLn() instead of characters through serial_getC().
+ * -v prints the changed flags at each expectation, useful when recording new captures.
+ *
+ * Capture format, one item per line:
+ *
+ *   # comment
+ *   > $$           command sent by the pendant, $I, $$ and $F start the matching parser request
+ *   = <check>      expectation on the data parsed from the lines received since the previous one
+ *   <anything>     a line received from the controller
+ *
+ * Checks:
+ *
+ *   changed <flag> ...     exactly these changed flags are set, they are cleared after the check
+ *   state <text>           mpos <x> <y> <z>        wco <x> <y> <z>         feed <value>
+ *   rpm <value>            alarm <n>               error <n>               message <text>
+ *   mpg <0|1>              bf <planner> <rx>       ln <n>                  ar <interval>
+ *   axes <n>               received <info|settings|files>
+ *   setting <id> <value>   rx_size <n>             planner <n>             sd <0|1>
+ *   files <n>              file <idx> <name> <length>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+
+#include "../src/grbl/parser.h"
+
+#define CAPTURE_SIZE 0x40000
+#define TOLERANCE 0.0005f
+
+typedef struct {
+    const char *name;
+    uint64_t mask;
+} flag_name_t;
+
+static struct {
+    char data[CAPTURE_SIZE];
+    size_t head;
+    size_t tail;
+} rx;
+
+static bool line_mode = false, verbose = false;
+static uint_fast8_t flag_count = 0;
+static flag_name_t flag[64];
+static grbl_data_t *grbl;
+static grbl_info_t *grbl_info = NULL;
+static sd_files_t *listing = NULL;
+static struct {
+    bool info;
+    bool settings;
+    bool files;
+} received = {0};
+
+/*
+ * Stubs for the firmware interfaces used by the parser
+ *
+ */
+
+uint32_t lcd_systicks (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+int16_t serial_getC (void)
+{
+    return rx.tail == rx.head ? SERIAL_NO_DATA : (int16_t)rx.data[rx.tail++];
+}
+
+// Only used with -l, the parser then gets complete lines without terminators as from the DMA receiver
+int16_t serial_getLn (char *line, uint_fast16_t size)
+{
+    char *eol;
+    size_t length;
+
+    if(!line_mode || rx.tail == rx.head || !(eol = memchr(&rx.data[rx.tail], '\n', rx.head - rx.tail)))
+        return SERIAL_NO_DATA;
+
+    length = eol - &rx.data[rx.tail];
+
+    if(length && eol[-1] == '\r')
+        length--;
+
+    if(length > size - 1)
+        length = size - 1;
+
+    memcpy(line, &rx.data[rx.tail], length);
+    line[length] = '\0';
+    rx.tail = eol - rx.data + 1;
+
+    return (int16_t)length;
+}
+
+bool serial_putC (const char c)
+{
+    return true;
+}
+
+void serial_writeLn (const char *data)
+{
+}
+
+void serial_RxCancel (void)
+{
+}
+
+/*
+ * Parser callbacks
+ *
+ */
+
+static void onReport (char *line)
+{
+}
+
+static void onInfo (grbl_info_t *info)
+{
+    received.info = true;
+    grbl_info = info;
+}
+
+static void onSettings (settings_t *settings)
+{
+    received.settings = true;
+}
+
+static void onFiles (sd_files_t *files)
+{
+    if(files->complete) {
+        received.files = true;
+        listing = files;
+    }
+}
+
+/*
+ * Replay
+ *
+ */
+
+#define FLAG(f) { changes_t changes = {0}; changes.f = 1; flag[flag_count].name = #f; flag[flag_count++].mask = changes.flags; }
+
+static void initFlagNames (void)
+{
+    FLAG(xpos) FLAG(ypos) FLAG(zpos) FLAG(apos) FLAG(bpos) FLAG(cpos) FLAG(upos) FLAG(vpos)
+    FLAG(mpg) FLAG(state) FLAG(offset) FLAG(await_ack) FLAG(await_wco_ok) FLAG(leds) FLAG(dist)
+    FLAG(message) FLAG(feed) FLAG(rpm) FLAG(alarm) FLAG(error) FLAG(xmode) FLAG(coolant) FLAG(spindle)
+    FLAG(pins) FLAG(reset) FLAG(feed_override) FLAG(rapid_override) FLAG(rpm_override) FLAG(jog_mode)
+    FLAG(tlo_reference) FLAG(auto_reporting) FLAG(axes) FLAG(buffers) FLAG(line_number)
+}
+
+static void flagNames (uint64_t flags, char *names)
+{
+    uint_fast8_t idx;
+
+    *names = '\0';
+
+    for(idx = 0; idx < flag_count; idx++) {
+        if(flags & flag[idx].mask) {
+            strcat(names, " ");
+            strcat(names, flag[idx].name);
+        }
+    }
+}
+
+static void receive (const char *line)
+{
+    size_t length = strlen(line);
+
+    if(rx.tail == rx.head)
+        rx.tail = rx.head = 0;
+
+    if(rx.head + length + 2 <= CAPTURE_SIZE) {
+        memcpy(&rx.data[rx.head], line, length);
+        rx.head += length;
+        rx.data[rx.head++] = '\r';
+        rx.data[rx.head++] = '\n';
+    }
+}
+
+static void sendCommand (const char *command)
+{
+    grblPollSerial();
+
+    grbl->mpgMode = true; // the pendant only sends commands in MPG mode
+
+    if(!strcmp(command, "$I"))
+        grblGetInfo(onInfo);
+    else if(!strcmp(command, "$$"))
+        grblGetSettings(onSettings);
+    else if(!strcmp(command, "$F"))
+        grblGetSDFiles(onFiles);
+}
+
+static bool matchFloat (float value, const char *expected)
+{
+    return fabsf(value - strtof(expected, NULL)) <= TOLERANCE;
+}
+
+static bool matchCoords (axes_coords_t *coords, char *args)
+{
+    uint_fast8_t idx = 0;
+    char *arg = strtok(args, " ");
+    bool ok = arg != NULL;
+
+    while(ok && arg && idx < N_AXIS_MAX) {
+        ok = matchFloat(coords->values[idx++], arg);
+        arg = strtok(NULL, " ");
+    }
+
+    return ok;
+}
+
+// Returns NULL if the check passes, else a description of the data parsed
+static const char *check (char *check)
+{
+    static char actual[400];
+
+    char *args = strchr(check, ' '), *arg;
+    bool ok = false;
+    const grbl_setting_t *setting;
+
+    grblPollSerial();
+
+    if(args)
+        *args++ = '\0';
+    else
+        args = "";
+
+    *actual = '\0';
+
+    if(!strcmp(check, "changed")) {
+        uint64_t expected = 0;
+        uint_fast8_t idx;
+        for(arg = strtok(args, " "); arg; arg = strtok(NULL, " ")) {
+            for(idx = 0; idx < flag_count && strcmp(arg, flag[idx].name); idx++);
+            if(idx == flag_count)
+                return "unknown flag";
+            expected |= flag[idx].mask;
+        }
+        ok = grbl->changed.flags == expected;
+        flagNames(grbl->changed.flags, actual);
+        grbl->changed.flags = 0;
+    } else if(!strcmp(check, "state")) {
+        ok = !strcmp(grbl->grbl.state_text, args);
+        strcpy(actual, grbl->grbl.state_text);
+    } else if(!strcmp(check, "mpos")) {
+        ok = matchCoords(&grbl->position, args);
+        sprintf(actual, "%.3f %.3f %.3f", grbl->position.x, grbl->position.y, grbl->position.z);
+    } else if(!strcmp(check, "wco")) {
+        ok = matchCoords(&grbl->offset, args);
+        sprintf(actual, "%.3f %.3f %.3f", grbl->offset.x, grbl->offset.y, grbl->offset.z);
+    } else if(!strcmp(check, "feed")) {
+        ok = matchFloat(grbl->feed_rate, args);
+        sprintf(actual, "%.3f", grbl->feed_rate);
+    } else if(!strcmp(check, "rpm")) {
+        ok = matchFloat(grbl->spindle.rpm_programmed, args);
+        sprintf(actual, "%.3f", grbl->spindle.rpm_programmed);
+    } else if(!strcmp(check, "alarm")) {
+        ok = grbl->alarm == atoi(args);
+        sprintf(actual, "%d", grbl->alarm);
+    } else if(!strcmp(check, "error")) {
+        ok = grbl->error == atoi(args);
+        sprintf(actual, "%d", grbl->error);
+    } else if(!strcmp(check, "message")) {
+        ok = !strcmp(grbl->message, args);
+        strcpy(actual, grbl->message);
+    } else if(!strcmp(check, "mpg")) {
+        ok = grbl->mpgMode == (atoi(args) != 0);
+        sprintf(actual, "%d", grbl->mpgMode);
+    } else if(!strcmp(check, "bf")) {
+        char expected[20];
+        sprintf(actual, "%u %u", grbl->buffers.planner, grbl->buffers.rx);
+        sprintf(expected, "%d %d", atoi(args), atoi(strchr(args, ' ') ? strchr(args, ' ') : "0"));
+        ok = grbl->buffers.reported && !strcmp(actual, expected);
+    } else if(!strcmp(check, "ln")) {
+        ok = grbl->line_number == strtoul(args, NULL, 10);
+        sprintf(actual, "%lu", (unsigned long)grbl->line_number);
+    } else if(!strcmp(check, "ar")) {
+        ok = grbl->autoReporting && grbl->autoReportingInterval == strtoul(args, NULL, 10);
+        sprintf(actual, "%d %lu", grbl->autoReporting, (unsigned long)grbl->autoReportingInterval);
+    } else if(!strcmp(check, "axes")) {
+        ok = grbl->n_axis == atoi(args);
+        sprintf(actual, "%d", grbl->n_axis);
+    } else if(!strcmp(check, "received")) {
+        ok = (!strcmp(args, "info") && received.info) || (!strcmp(args, "settings") && received.settings) || (!strcmp(args, "files") && received.files);
+        sprintf(actual, "info:%d settings:%d files:%d", received.info, received.settings, received.files);
+        received.info = received.settings = received.files = false;
+    } else if(!strcmp(check, "setting")) {
+        uint16_t id = (uint16_t)strtoul(args, &arg, 10);
+        arg += *arg == ' ';
+        if((setting = grblGetSetting(id))) switch(setting->type) {
+
+            case SettingValue_Integer:
+                sprintf(actual, "%ld", (long)setting->integer);
+                ok = setting->integer == strtol(arg, NULL, 10);
+                break;
+
+            case SettingValue_Decimal:
+                sprintf(actual, "%.3f", setting->decimal);
+                ok = matchFloat(setting->decimal, arg);
+                break;
+
+            default:
+                strcpy(actual, grblGetSettingString(setting));
+                ok = !strcmp(actual, arg);
+                break;
+        } else
+            strcpy(actual, "not found");
+    } else if(!strcmp(check, "rx_size")) {
+        ok = grblGetRxBufferSize() == strtoul(args, NULL, 10);
+        sprintf(actual, "%lu", (unsigned long)grblGetRxBufferSize());
+    } else if(!strcmp(check, "planner")) {
+        ok = grbl_info && grbl_info->planner_blocks == strtoul(args, NULL, 10);
+        sprintf(actual, "%lu", grbl_info ? (unsigned long)grbl_info->planner_blocks : 0UL);
+    } else if(!strcmp(check, "sd")) {
+        ok = grblGetOptions().sd_card == (atoi(args) != 0);
+        sprintf(actual, "%d", grblGetOptions().sd_card);
+    } else if(!strcmp(check, "files")) {
+        ok = listing && listing->num_files == strtoul(args, NULL, 10);
+        sprintf(actual, "%lu", listing ? (unsigned long)listing->num_files : 0UL);
+    } else if(!strcmp(check, "file")) {
+        sd_file_t *file;
+        char name[200];
+        unsigned long length;
+        uint_fast16_t idx = (uint_fast16_t)strtoul(args, &arg, 10);
+        if(sscanf(arg, " %199s %lu", name, &length) == 2 && (file = grblGetSDFile(listing, idx))) {
+            ok = !strcmp(file->name, name) && file->length == length;
+            sprintf(actual, "%s %lu", file->name, (unsigned long)file->length);
+        } else
+            strcpy(actual, "not found");
+    } else
+        return "unknown check";
+
+    if(verbose)
+        printf("  = %s -> %s\n", check, actual);
+
+    return ok ? NULL : actual;
+}
+
+static char *readCapture (const char *path)
+{
+    char *capture = NULL;
+    long size;
+    FILE *file = fopen(path, "rb");
+
+    if(file) {
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+        rewind(file);
+        if((capture = malloc(size + 1))) {
+            capture[fread(capture, 1, size, file)] = '\0';
+        }
+        fclose(file);
+    }
+
+    return capture;
+}
+
+static uint_fast16_t replay (const char *path)
+{
+    uint_fast16_t failed = 0, line_no = 0;
+    char *capture = readCapture(path), *line, *next;
+    const char *actual;
+
+    if(capture == NULL) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        return 1;
+    }
+
+    for(line = capture; line && *line; line = next) {
+
+        if((next = strchr(line, '\n')))
+            *next++ = '\0';
+
+        line[strcspn(line, "\r")] = '\0';
+        line_no++;
+
+        if(*line == '#' || *line == '\0')
+            continue;
+
+        if(line[0] == '>' && line[1] == ' ')
+            sendCommand(line + 2);
+        else if(line[0] == '=' && line[1] == ' ') {
+            char expectation[MAX_BLOCK_LENGTH];
+            strncpy(expectation, line + 2, sizeof(expectation) - 1);
+            expectation[sizeof(expectation) - 1] = '\0';
+            if((actual = check(line + 2))) {
+                printf("%s:%u: %s failed, got: %s\n", path, (unsigned)line_no, expectation, actual);
+                failed++;
+            }
+        } else
+            receive(line);
+    }
+
+    grblPollSerial();
+    free(capture);
+
+    return failed;
+}
+
+/*
+ * Benchmark
+ *
+ */
+
+static uint64_t nanoseconds (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// Feeds a line repeatedly, returns the average ns per line
+static double timeLine (const char *line, uint32_t passes)
+{
+    uint32_t pass;
+    uint64_t start = nanoseconds();
+
+    for(pass = 0; pass < passes; pass++) {
+        receive(line);
+        grblPollSerial();
+    }
+
+    return (double)(nanoseconds() - start) / passes;
+}
+
+static int benchmark (uint32_t passes, int count, char **paths)
+{
+    static char lines[CAPTURE_SIZE];
+
+    int idx;
+    size_t used = 0;
+    uint32_t pass, reports = 0, n_lines = 0;
+    uint64_t start, elapsed;
+    char *capture, *line, *next, fields[32][8];
+    uint_fast8_t n_fields = 0, field;
+    double baseline;
+
+    // Collect the controller output of all captures
+    for(idx = 0; idx < count; idx++) {
+        if((capture = readCapture(paths[idx])) == NULL) {
+            fprintf(stderr, "%s: cannot read\n", paths[idx]);
+            return 1;
+        }
+        for(line = capture; line && *line; line = next) {
+            if((next = strchr(line, '\n')))
+                *next++ = '\0';
+            line[strcspn(line, "\r")] = '\0';
+            if(*line == '#' || *line == '\0' || ((*line == '>' || *line == '=') && line[1] == ' '))
+                continue;
+            if(used + strlen(line) + 1 < sizeof(lines)) {
+                strcpy(&lines[used], line);
+                used += strlen(line) + 1;
+                n_lines++;
+                if(*line == '<') {
+                    char *sep = line;
+                    reports++;
+                    while((sep = strchr(sep + 1, '|'))) { // collect the field types reported
+                        size_t length = strcspn(sep + 1, ":|>");
+                        if(length > sizeof(fields[0]) - 1)
+                            length = sizeof(fields[0]) - 1;
+                        for(field = 0; field < n_fields && (strncmp(fields[field], sep + 1, length) || fields[field][length]); field++);
+                        if(field == n_fields && n_fields < 32) {
+                            strncpy(fields[n_fields], sep + 1, length);
+                            fields[n_fields++][length] = '\0';
+                        }
+                    }
+                }
+            }
+        }
+        free(capture);
+    }
+
+    printf("%s mode, %lu lines of which %lu reports, %lu passes\n", line_mode ? "line" : "character",
+            (unsigned long)n_lines, (unsigned long)reports, (unsigned long)passes);
+
+    start = nanoseconds();
+
+    for(pass = 0; pass < passes; pass++) {
+        for(line = lines; line < &lines[used]; line += strlen(line) + 1) {
+            receive(line);
+            grblPollSerial();
+        }
+    }
+
+    elapsed = nanoseconds() - start;
+
+    printf("  all lines: %.0f ns per line, %.0f lines/s\n", (double)elapsed / ((double)n_lines * passes), 1e9 * n_lines * passes / elapsed);
+
+    if(reports) {
+
+        start = nanoseconds();
+
+        for(pass = 0; pass < passes; pass++) {
+            for(line = lines; line < &lines[used]; line += strlen(line) + 1) {
+                if(*line == '<') {
+                    receive(line);
+                    grblPollSerial();
+                }
+            }
+        }
+
+        elapsed = nanoseconds() - start;
+
+        printf("  reports: %.0f ns per report, %.0f reports/s\n", (double)elapsed / ((double)reports * passes), 1e9 * reports * passes / elapsed);
+    }
+
+    // Per field cost: a report with the first sample of the field, less a report with the state only
+    baseline = timeLine("<Idle>", passes * 10);
+    printf("  <Idle> %.0f ns\n", baseline);
+
+    for(field = 0; field < n_fields; field++) {
+        for(line = lines; line < &lines[used]; line += strlen(line) + 1) {
+            char *sep = line, *end;
+            bool found = false;
+            if(*line != '<')
+                continue;
+            while(!found && (sep = strchr(sep + 1, '|'))) {
+                if((found = !strncmp(sep + 1, fields[field], strlen(fields[field])) && strchr(":|>", sep[1 + strlen(fields[field])]))) {
+                    char report[MAX_BLOCK_LENGTH];
+                    end = sep + 1 + strcspn(sep + 1, "|>");
+                    snprintf(report, sizeof(report), "<Idle|%.*s>", (int)(end - sep - 1), sep + 1);
+                    printf("  %-5s %6.0f ns  %s\n", fields[field], timeLine(report, passes * 10) - baseline, report);
+                }
+            }
+            if(found)
+                break;
+        }
+    }
+
+    return 0;
+}
+
+int main (int argc, char **argv)
+{
+    int idx = 1;
+    uint32_t passes = 0;
+    uint_fast16_t failed = 0;
+
+    while(idx < argc && argv[idx][0] == '-') {
+        if(!strcmp(argv[idx], "-l"))
+            line_mode = true;
+        else if(!strcmp(argv[idx], "-v"))
+            verbose = true;
+        else if(!strcmp(argv[idx], "-b") && idx + 1 < argc)
+            passes = (uint32_t)strtoul(argv[++idx], NULL, 10);
+        else {
+            fprintf(stderr, "usage: replay [-l] [-v] [-b passes] capture...\n");
+            return 2;
+        }
+        idx++;
+    }
+
+    initFlagNames();
+
+    grbl = setGrblReceiveCallback(onReport);
+    grbl->changed.flags = 0;
+
+    if(passes)
+        return benchmark(passes, argc - idx, &argv[idx]);
+
+    for(; idx < argc; idx++) {
+        uint_fast16_t errors = replay(argv[idx]);
+        printf("%s: %s\n", argv[idx], errors ? "FAILED" : "passed");
+        failed += errors;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -64,3 +64,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #if TOUCH_ENABLE && !defined(TOUCH_MAXSAMPLES)
 #define TOUCH_MAXSAMPLES 50
 #endif
+
+// number of fonts that get a glyph offset index (512 bytes RAM each), additional fonts use a linear search
+#ifndef FONT_INDEX_SIZE
+#define FONT_INDEX_SIZE 4
+#endif
+
+// size in pixels of the buffer used for opaque glyph rendering, glyphs that do not fit are drawn column by column
+#ifndef GLYPH_BUFFER_SIZE
+#define GLYPH_BUFFER_SIZE 3072
+#endif
@@ -41,9 +41,45 @@
 colorRGB565 fgColor;
 colorRGB565 bgColor;
 static lcd_driver_t driver;
+static lcd_rect_t extent = {
+    .xMin = UINT16_MAX,
+    .yMin = UINT16_MAX,
+    .xMax = 0,
+    .yMax = 0
+};
 
 /**/
 
+// Keeps the bounding box of everything drawn since the last call to getPaintExtent() with reset set
+static inline void setArea (uint16_t xStart, uint16_t yStart, uint16_t xEnd, uint16_t yEnd)
+{
+    if(xStart < extent.xMin)
+        extent.xMin = xStart;
+    if(yStart < extent.yMin)
+        extent.yMin = yStart;
+    if(xEnd > extent.xMax)
+        extent.xMax = xEnd;
+    if(yEnd > extent.yMax)
+        extent.yMax = yEnd;
+
+    lcd_setArea(xStart, yStart, xEnd, yEnd);
+}
+
+bool getPaintExtent (lcd_rect_t *rect, bool reset)
+{
+    bool painted = extent.xMin <= extent.xMax;
+
+    if(painted)
+        *rect = extent;
+
+    if(reset) {
+        extent.xMin = extent.yMin = UINT16_MAX;
+        extent.xMax = extent.yMax = 0;
+    }
+
+    return painted;
+}
+
 bool setSysTickCallback (systick_callbak_ptr callback)
 {
     delayms_attach(callback);
@@ -111,7 +147,7 @@ void clearScreen (bool blackWhite)
 {
     setColor(blackWhite ? (RGBColor_t)White : (RGBColor_t)Black);
     setBackgroundColor(blackWhite ? (RGBColor_t)Black : (RGBColor_t)White);
-    lcd_setArea(0, 0, driver.display.Width - 1, driver.display.Height - 1);
+    setArea(0, 0, driver.display.Width - 1, driver.display.Height - 1);
     lcd_writePixel(bgColor, (uint32_t)driver.display.Width * (uint32_t)driver.display.Height);
 }
 
@@ -128,6 +164,54 @@ __attribute__((optimize(0))) inline static uint16_t getoffset (Font *font, uint8
     return offset;
 }
 
+/* Glyph offset index, built on first use of a font */
+
+typedef struct {
+    Font *font;
+    uint8_t spaceWidth;
+    uint16_t offset[256]; // column offset of each glyph in the font bitmap
+} font_index_t;
+
+static font_index_t fontIndex[FONT_INDEX_SIZE] = {0};
+static font_index_t *lastIndex = NULL;
+
+static uint8_t spaceWidth (Font *font)
+{
+    return ('0' < font->firstChar || '0' > font->lastChar ? font->width / 4 : font->charWidths['0' - font->firstChar]) + 2;
+}
+
+static font_index_t *getFontIndex (Font *font)
+{
+    if(lastIndex && lastIndex->font == font)
+        return lastIndex;
+
+    uint_fast16_t idx = 0, c, glyphs;
+
+    while(idx < FONT_INDEX_SIZE && fontIndex[idx].font && fontIndex[idx].font != font)
+        idx++;
+
+    if(idx == FONT_INDEX_SIZE)
+        return NULL;
+
+    if(fontIndex[idx].font == NULL) {
+
+        uint16_t offset = 0;
+        uint8_t *widths = font->charWidths; // charWidths is declared with one element, indexing it in a loop lets the compiler assume a single iteration
+
+        glyphs = font->lastChar - font->firstChar + 1;
+
+        for(c = 0; c < glyphs; c++) {
+            fontIndex[idx].offset[c] = offset;
+            offset += widths[c];
+        }
+
+        fontIndex[idx].spaceWidth = spaceWidth(font);
+        fontIndex[idx].font = font;
+    }
+
+    return lastIndex = &fontIndex[idx];
+}
+
 uint8_t getFontWidth (Font *font)
 {
     return font->width;
@@ -140,12 +224,19 @@ uint8_t getFontHeight (Font *font)
 
 uint8_t getSpaceWidth (Font *font)
 {
-    return ('0' < font->firstChar || '0' > font->lastChar ? font->width / 4 : font->charWidths['0' - font->firstChar]) + 2;
+    font_index_t *index = getFontIndex(font);
+
+    return index ? index->spaceWidth : spaceWidth(font);
+}
+
+static inline uint8_t charWidth (Font *font, uint8_t space, char c)
+{
+    return c != ' ' && (c < font->firstChar || c > font->lastChar) ? 0 : (c == ' ' || font->charWidths[c - font->firstChar] == 0 ? space : font->charWidths[c - font->firstChar] + 2);
 }
 
 uint8_t getCharWidth (Font *font, char c)
 {
-    return c != ' ' && (c < font->firstChar || c > font->lastChar) ? 0 : (c == ' ' || font->charWidths[c - font->firstChar] == 0 ? getSpaceWidth(font) : font->charWidths[c - font->firstChar] + 2);
+    return charWidth(font, getSpaceWidth(font), c);
 }
 
 uint16_t getStringWidth (Font *font, const char *string)
@@ -153,13 +244,82 @@ uint16_t getStringWidth (Font *font, const char *string)
 
     char c;
     uint16_t width = 0;
+    uint8_t space = getSpaceWidth(font);
 
     while((c = *string++))
-        width += getCharWidth(font, c);
+        width += charWidth(font, space, c);
 
     return width;
 }
 
+// returns pixels for one glyph column, LSB is the top row
+inline static uint64_t getColumn (uint8_t *fontData, uint_fast16_t dataIndex, uint_fast16_t preShift)
+{
+    uint64_t pixels;
+
+#ifdef FONT_WORD_READ
+    pixels = ((uint64_t)*((uint32_t *)&fontData[dataIndex + 4])) << 32;
+    pixels |= *((uint32_t *)&fontData[dataIndex]);
+#else
+    uint8_t *ptr = &fontData[dataIndex + 7];
+    uint32_t data = *ptr-- << 24;
+    data |= *ptr-- << 16;
+    data |= *ptr-- << 8;
+    data |= *ptr--;
+
+    pixels = data;
+
+    data = *ptr-- << 24;
+    data |= *ptr-- << 16;
+    data |= *ptr-- << 8;
+    data |= *ptr;
+    pixels = (pixels << 32) | data;
+#endif
+
+    return pixels >> preShift;
+}
+
+#if GLYPH_BUFFER_SIZE
+
+static uint16_t glyphBuffer[GLYPH_BUFFER_SIZE];
+
+// Opaque glyph blit: the glyph, including the blank leading and trailing column, is expanded
+// row by row into glyphBuffer and sent to the panel through a single address window.
+static void drawCharOpaque (Font *font, uint16_t x, uint16_t y, uint_fast16_t bitOffset, uint_fast8_t columns, bool paintSpace)
+{
+    uint8_t *fontData = font->charWidths + font->lastChar - font->firstChar + 1;
+    uint_fast16_t row, column, height = font->height;
+    uint16_t fg = ((uint16_t)fgColor.lowByte << 8) | fgColor.highByte, bg = ((uint16_t)bgColor.lowByte << 8) | bgColor.highByte, *pixel;
+    uint64_t pixels;
+
+    for(column = 0; column < columns; column++) {
+
+        pixel = &glyphBuffer[column];
+
+        if(column == 0 || column == columns - 1 || paintSpace) {
+            row = height;
+            do {
+                *pixel = bg;
+                pixel += columns;
+            } while(--row);
+        } else {
+            pixels = getColumn(fontData, bitOffset >> 3, bitOffset & 0x07);
+            row = height;
+            do {
+                *pixel = pixels & 0x01 ? fg : bg;
+                pixels >>= 1;
+                pixel += columns;
+            } while(--row);
+            bitOffset += height;
+        }
+    }
+
+    setArea(x, y - height, x + columns - 1, y - 1);
+    lcd_writePixels(glyphBuffer, columns * height);
+}
+
+#endif
+
 uint8_t drawChar (Font *font, uint16_t x, uint16_t y, char c, bool opaque)
 {
     uint8_t width = getCharWidth(font, c);
@@ -171,7 +331,9 @@ uint8_t drawChar (Font *font, uint16_t x, uint16_t y, char c, bool opaque)
         uint64_t pixels;
         bool paintSpace;
 
-        bitOffset = getoffset(font, (uint8_t)c) * font->height;
+        font_index_t *index = getFontIndex(font);
+
+        bitOffset = (index && (uint8_t)c >= font->firstChar ? index->offset[(uint8_t)c - font->firstChar] : getoffset(font, (uint8_t)c)) * font->height;
         dataIndex = bitOffset >> 3;
         preShift = bitOffset - (dataIndex << 3);
         fontColumn = width;
@@ -179,6 +341,13 @@ uint8_t drawChar (Font *font, uint16_t x, uint16_t y, char c, bool opaque)
 
         paintSpace = c == ' ' || !font->charWidths[c - font->firstChar];
 
+#if GLYPH_BUFFER_SIZE
+        if(opaque && fontColumn * font->height <= GLYPH_BUFFER_SIZE) {
+            drawCharOpaque(font, x, y, bitOffset, fontColumn, paintSpace);
+            return width + 2;
+        }
+#endif
+
         if(!paintSpace || opaque) {
 
             while(fontColumn--) {
@@ -187,29 +356,11 @@ uint8_t drawChar (Font *font, uint16_t x, uint16_t y, char c, bool opaque)
                 displayRow = y - fontRow;
 
                 if(opaque)
-                    lcd_setArea(x, displayRow, x, y);
+                    setArea(x, displayRow, x, y);
 
                 if(!((fontColumn == 0) || (fontColumn > width)) && !paintSpace) {
 
-#ifdef FONT_WORD_READ
-                    pixels = ((uint64_t)*((uint32_t *)&fontData[dataIndex + 4])) << 32;
-                    pixels |= *((uint32_t *)&fontData[dataIndex]);
-#else
-                    uint8_t *ptr = &fontData[dataIndex + 7];
-                    uint32_t data = *ptr-- << 24;
-                    data |= *ptr-- << 16;
-                    data |= *ptr-- << 8;
-                    data |= *ptr--;
-
-                    pixels = data;
-
-                    data = *ptr-- << 24;
-                    data |= *ptr-- << 16;
-                    data |= *ptr-- << 8;
-                    data |= *ptr;
-                    pixels = (pixels << 32) | data;
-#endif
-                    pixels >>= preShift;
+                    pixels = getColumn(fontData, dataIndex, preShift);
 
 //#define FONT_SLOW_PLOT
 #ifdef FONT_SLOW_PLOT
@@ -217,7 +368,7 @@ uint8_t drawChar (Font *font, uint16_t x, uint16_t y, char c, bool opaque)
 
                         if(pixels & 0x01) {
                             if(!opaque)
-                                lcd_setArea(x, displayRow, x, displayRow);
+                                setArea(x, displayRow, x, displayRow);
                             lcd_writePixel(fgColor, 1);
                         } else if(opaque)
                             lcd_writePixel(bgColor, 1);
@@ -237,7 +388,7 @@ uint8_t drawChar (Font *font, uint16_t x, uint16_t y, char c, bool opaque)
                         if((pixels & 0x01) != paint || !fontRow) {
                             if(paint) {
                                 if(!opaque)
-                                    lcd_setArea(x, displayRow, x, displayRow + count - 1);
+                                    setArea(x, displayRow, x, displayRow + count - 1);
                                 lcd_writePixel(fgColor, count);
                             } else if(opaque)
                                 lcd_writePixel(bgColor, count);
@@ -309,7 +460,7 @@ bool drawStringAligned (Font *font, uint16_t x, uint16_t y, const char *string,
 
 void drawPixel (uint16_t x, uint16_t y)
 {
-    lcd_setArea(x, y, x, y);
+    setArea(x, y, x, y);
     lcd_writePixel(fgColor, 1);
 }
 
@@ -321,7 +472,7 @@ void drawLine (uint16_t xStart, uint16_t yStart, uint16_t xEnd, uint16_t yEnd)
             xEnd = xStart;
             xStart = yEnd;
         }
-        lcd_setArea(xStart, yStart, xEnd, yStart);
+        setArea(xStart, yStart, xEnd, yStart);
         lcd_writePixel(fgColor, xEnd - xStart + 1);
     } else if (xStart == xEnd) { // check if vertical
         if(yStart > yEnd) {
@@ -329,7 +480,7 @@ void drawLine (uint16_t xStart, uint16_t yStart, uint16_t xEnd, uint16_t yEnd)
             yEnd = yStart;
             yStart = xEnd;
         }
-        lcd_setArea(xStart, yStart, xStart, yEnd);
+        setArea(xStart, yStart, xStart, yEnd);
         lcd_writePixel(fgColor, yEnd - yStart + 1);
     } else { // angled
         int_fast16_t dx, dy, sx, sy;
@@ -379,7 +530,7 @@ void drawRect (uint16_t xStart, uint16_t yStart, uint16_t xEnd, uint16_t yEnd)
 
 void fillRect (uint16_t xStart, uint16_t yStart, uint16_t xEnd, uint16_t yEnd)
 {
-    lcd_setArea(xStart, yStart, xEnd, yEnd);
+    setArea(xStart, yStart, xEnd, yEnd);
     lcd_writePixel(fgColor, (uint32_t)(xEnd - xStart + 1) * (uint32_t)(yEnd - yStart + 1));
 }
 
@@ -462,7 +613,7 @@ static bool jpgBitBlt (JDEC* jd, void* bitmap, JRECT* rect)
 // TODO: implement clipping
     jd = jd; // Suppress compiler warning
 
-    lcd_setArea(ifp.x + rect->left, ifp.y + rect->top, ifp.x + rect->right, ifp.y + rect->bottom);
+    setArea(ifp.x + rect->left, ifp.y + rect->top, ifp.x + rect->right, ifp.y + rect->bottom);
     lcd_writePixels((uint16_t *)bitmap, (rect->right - rect->left + 1) * (rect->bottom - rect->top + 1));
 
     return true;
@@ -518,7 +669,7 @@ void drawImageMono (uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *dat
     uint16_t xpos;
     uint8_t pixels, mask;
 
-    lcd_setArea(x, y, x + w - 1, y + h - 1);
+    setArea(x, y, x + w - 1, y + h - 1);
 
     xpos = w = (w / 8);
 
@@ -62,6 +62,13 @@ typedef union {
     };
 } colorRGB565;
 
+typedef struct {
+    uint16_t xMin;
+    uint16_t yMin;
+    uint16_t xMax;
+    uint16_t yMax;
+} lcd_rect_t;
+
 typedef struct {
     lcd_display_t display;
     void (*touchIRQHandler)(void);
@@ -76,6 +83,7 @@ void displayOn (bool on);
 void setColor (RGBColor_t color);
 void setBackgroundColor (RGBColor_t color);
 bool setSysTickCallback (void (*fn)(void));
+bool getPaintExtent (lcd_rect_t *rect, bool reset);
 //
 void clearScreen (bool blackWhite);
 void drawPixel (uint16_t x, uint16_t y);
@@ -114,9 +122,14 @@ extern void lcd_driverInit (lcd_driver_t *driver);
 extern void lcd_delayms (uint16_t ms);
 extern uint32_t lcd_systicks (void);
 extern void lcd_writeData (uint8_t data);
+extern void lcd_writeData16 (uint16_t data);
 extern void lcd_writePixel (colorRGB565 color, uint32_t count);
 extern void lcd_writePixels (uint16_t *pixels, uint32_t length);
 extern void lcd_writeCommand (uint8_t command);
+extern void lcd_busyWait (void);
+#ifdef LCD_FILL_BENCHMARK
+extern uint32_t lcd_fillBenchmark (uint_fast8_t passes);
+#endif
 extern void lcd_readDataBegin (uint8_t command);
 extern uint8_t lcd_readData (void);
 extern void lcd_readDataEnd (void);
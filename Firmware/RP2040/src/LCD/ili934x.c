@@ -23,19 +23,13 @@ void lcd_setArea (uint16_t xStart, uint16_t yStart, uint16_t xEnd, uint16_t yEnd
 {
     lcd_writeCommand(CASETP);
 
-    lcd_writeData(xStart >> 8);
-    lcd_writeData(xStart);
-
-    lcd_writeData(xEnd >> 8);
-    lcd_writeData(xEnd);
+    lcd_writeData16(xStart);
+    lcd_writeData16(xEnd);
 
     lcd_writeCommand(PASETP);
 
-    lcd_writeData(yStart >> 8);
-    lcd_writeData(yStart);
-
-    lcd_writeData(yEnd >> 8);
-    lcd_writeData(yEnd);
+    lcd_writeData16(yStart);
+    lcd_writeData16(yEnd);
 
     lcd_writeCommand(RAMWRP);
     // data to follow
@@ -19,9 +19,11 @@ __attribute__((weak)) void lcd_driverInit (lcd_driver_t *driver) {}
 __attribute__((weak)) void lcd_delayms (uint16_t ms) {}
 __attribute__((weak)) uint32_t lcd_systicks (void) { return 0; }
 __attribute__((weak)) void lcd_writeData (uint8_t data) {}
+__attribute__((weak)) void lcd_writeData16 (uint16_t data) { lcd_writeData(data >> 8); lcd_writeData(data & 0xFF); }
 __attribute__((weak)) void lcd_writePixel (colorRGB565 color, uint32_t count) {}
 __attribute__((weak)) void lcd_writePixels (uint16_t *pixels, uint32_t length) {}
 __attribute__((weak)) void lcd_writeCommand (uint8_t command) {}
+__attribute__((weak)) void lcd_busyWait (void) {}
 __attribute__((weak)) void lcd_readDataBegin (uint8_t command) {}
 __attribute__((weak)) uint8_t lcd_readData (void) { return 0; }
 __attribute__((weak)) void lcd_readDataEnd (void) {}
@@ -48,3 +48,54 @@
 #ifndef UILIB_KEYPAD_ENABLE
 #define UILIB_KEYPAD_ENABLE    0
 #endif
+
+// Number of rectangles kept in the dirty and painted region lists, overlapping
+// rectangles are merged and a full list merges the closest pair.
+#ifndef UILIB_DIRTY_RECTS
+#define UILIB_DIRTY_RECTS      8
+#endif
+
+// Widget pool sizes, widgets are allocated from fixed size per type slabs.
+// List elements are allocated from the button slab. Canvases are created on first
+// use and kept, the comments give the number used with all of them created.
+#ifndef UILIB_POOL_CANVASES
+#define UILIB_POOL_CANVASES    12 // 10 canvases
+#endif
+#ifndef UILIB_POOL_FRAMES
+#define UILIB_POOL_FRAMES      4 // 1, confirm
+#endif
+#ifndef UILIB_POOL_LISTS
+#define UILIB_POOL_LISTS       2 // 1, SD card
+#endif
+#ifndef UILIB_POOL_BUTTONS
+#define UILIB_POOL_BUTTONS     32 // 26, 18 buttons and 8 SD card list elements
+#endif
+#ifndef UILIB_POOL_IMAGES
+#define UILIB_POOL_IMAGES      2 // 1, boot logo
+#endif
+#ifndef UILIB_POOL_LABELS
+#define UILIB_POOL_LABELS      32 // 27, DRO 8 + one per axis up to 6, diagnostics 7, sender 4, utilities 2
+#endif
+#ifndef UILIB_POOL_CHECKBOXES
+#define UILIB_POOL_CHECKBOXES  6 // 3, common
+#endif
+#ifndef UILIB_POOL_TEXTBOXES
+#define UILIB_POOL_TEXTBOXES   12 // 10, threading 6 and common 4
+#endif
+// Size of the string buffers embedded in buttons (truncated labels) and textboxes (bound values)
+#ifndef UILIB_BUTTON_LABEL_LENGTH
+#define UILIB_BUTTON_LABEL_LENGTH 32
+#endif
+#ifndef UILIB_TEXTBOX_LENGTH
+#define UILIB_TEXTBOX_LENGTH   15
+#endif
+
+// Number of slots in the input event queue, one is kept free to tell a full queue from an empty one
+#ifndef UILIB_EVENT_QUEUE_SIZE
+#define UILIB_EVENT_QUEUE_SIZE 16
+#endif
+
+// Minimum time between dispatch of pointer move events in ms, moves arriving in between are merged
+#ifndef UILIB_POINTER_MOVE_INTERVAL
+#define UILIB_POINTER_MOVE_INTERVAL 20
+#endif
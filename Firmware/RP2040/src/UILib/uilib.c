@@ -64,10 +64,12 @@ typedef struct {
     uint32_t type;
     position_t pos;
     uint8_t tabNav;
+    uint32_t timestamp;
 } raw_event_t;
 
 typedef struct event_element_t {
     struct event_element_t *next;
+    volatile bool ready; // set by the producer when the event data is complete
     raw_event_t event;
     keypress_t keypress;
 #if UILIB_REMOTE_ENABLE
@@ -85,7 +87,6 @@ static char const *const data_format[] = {
 
 static bool hasNavigator;
 
-static volatile bool spin_lock = false;
 static uint8_t buttonHeight = 22, listGroup = 255;
 static Font *buttonFont = font_23x16;
 static volatile uint32_t pointerEvent = 0, systicks = 0, systickLimit = 10;
@@ -110,18 +111,70 @@ const position_t currPos = {
     .y = -1
 };
 
-static event_element_t events[16];
-static volatile event_element_t *event_tail, *event_head;
+static event_element_t events[UILIB_EVENT_QUEUE_SIZE];
+static volatile event_element_t *event_tail, *event_head, *event_last;
+static volatile uint32_t eventsDropped = 0;
+static uint32_t eventLatency = 0, eventLatencyMax = 0;
+
+typedef struct {
+    WidgetType type;
+    void *base;
+    uint16_t size;
+    uint8_t capacity;
+    uint8_t next;       // first slot not yet handed out
+    uint8_t used;
+    uint8_t peak;
+    uint16_t failed;
+    void *free;         // released slots, linked through their first word
+} widget_slab_t;
+
+typedef struct {
+    uint_fast8_t count;
+    lcd_rect_t rect[UILIB_DIRTY_RECTS];
+} region_t;
+
+typedef struct {
+    bool valid;
+    RGBColor_t color;
+    lcd_rect_t rect;
+} background_t;
+
+static region_t dirty = {0};    // areas to be repainted at the end of the current UILibProcessEvents() pass
+static region_t painted = {0};  // areas drawn to since the current canvas was displayed
+static background_t background = {0};
+
+static Canvas canvasPool[UILIB_POOL_CANVASES];
+static Frame framePool[UILIB_POOL_FRAMES];
+static List listPool[UILIB_POOL_LISTS];
+static Button buttonPool[UILIB_POOL_BUTTONS];
+static Image imagePool[UILIB_POOL_IMAGES];
+static Label labelPool[UILIB_POOL_LABELS];
+static CheckBox checkboxPool[UILIB_POOL_CHECKBOXES];
+static TextBox textboxPool[UILIB_POOL_TEXTBOXES];
+
+#define WIDGET_SLAB(t, pool) { .type = t, .base = pool, .size = sizeof(pool[0]), .capacity = sizeof(pool) / sizeof(pool[0]) }
+
+static widget_slab_t slabs[] = {
+    WIDGET_SLAB(WidgetCanvas, canvasPool),
+    WIDGET_SLAB(WidgetFrame, framePool),
+    WIDGET_SLAB(WidgetList, listPool),
+    WIDGET_SLAB(WidgetButton, buttonPool),
+    WIDGET_SLAB(WidgetImage, imagePool),
+    WIDGET_SLAB(WidgetLabel, labelPool),
+    WIDGET_SLAB(WidgetCheckBox, checkboxPool),
+    WIDGET_SLAB(WidgetTextBox, textboxPool)
+};
 
 static uint8_t tabNav = 0;
 static Widget *widgetGetNext (Widget * widget, uint8_t type, bool all);
 static Widget *widgetGetPrev (Widget * widget, uint8_t type, bool all);
+static void widgetPaint (Widget *parent, bool single, bool forceRepaint);
 
 bool UILibInit (void)
 {
     uint32_t i = (sizeof(events) / sizeof(event_element_t)) - 1;
 
-    event_head = event_tail = &events[0];
+    event_head = event_tail = event_last = &events[0];
 
     events[i].next = &events[0];
 
@@ -139,9 +192,70 @@ bool UILibInit (void)
 
 // private functions
 
+static widget_slab_t *slabGet (WidgetType type)
+{
+    uint_fast8_t i = sizeof(slabs) / sizeof(widget_slab_t);
+
+    if(type == WidgetListElement)
+        type = WidgetButton;
+
+    do {
+        if(slabs[--i].type == type)
+            return &slabs[i];
+    } while(i);
+
+    return NULL;
+}
+
+static void *slabAlloc (widget_slab_t *slab)
+{
+    void *slot = NULL;
+
+    if(slab->free) {
+        slot = slab->free;
+        slab->free = *(void **)slot;
+    } else if(slab->next < slab->capacity)
+        slot = (uint8_t *)slab->base + slab->size * slab->next++;
+
+    if(slot) {
+        if(++slab->used > slab->peak)
+            slab->peak = slab->used;
+    } else
+        slab->failed++;
+
+    return slot;
+}
+
+static void slabFree (widget_slab_t *slab, void *slot)
+{
+    *(void **)slot = slab->free;
+    slab->free = slot;
+    slab->used--;
+}
+
+static void widgetRelease (Widget *widget)
+{
+    Widget *next, *child = widget->firstChild;
+
+    while(child) {
+        next = child->nextSibling;
+        widgetRelease(child);
+        child = next;
+    }
+
+    if(widget == current.widget)
+        current.widget = NULL;
+
+    if(widget == (Widget *)caret.textbox)
+        caret.textbox = NULL;
+
+    slabFree(slabGet(widget->type), widget);
+}
+
 static Widget *widgetCreate (Widget *parent, WidgetType type, size_t size, uint16_t x, uint16_t y, uint16_t width, uint16_t height, void (*eventHandler)(Widget *self, Event *event))
 {
-    Widget *widget = malloc(size);
+    widget_slab_t *slab = slabGet(type);
+    Widget *widget = slab && size <= slab->size ? slabAlloc(slab) : NULL;
 
     if(widget) {
 
@@ -182,6 +296,125 @@ static Widget *widgetCreate (Widget *parent, WidgetType type, size_t size, uint1
     return widget;
 }
 
+// Dirty region handling
+
+static inline bool rectTouches (lcd_rect_t *a, lcd_rect_t *b)
+{
+    return a->xMin <= b->xMax + 1 && b->xMin <= a->xMax + 1 && a->yMin <= b->yMax + 1 && b->yMin <= a->yMax + 1;
+}
+
+static inline bool rectIntersectsWidget (lcd_rect_t *rect, Widget *widget)
+{
+    return rect->xMin <= widget->xMax && widget->x <= rect->xMax && rect->yMin <= widget->yMax && widget->y <= rect->yMax;
+}
+
+static inline lcd_rect_t rectUnion (lcd_rect_t a, lcd_rect_t b)
+{
+    return (lcd_rect_t){
+        .xMin = a.xMin < b.xMin ? a.xMin : b.xMin,
+        .yMin = a.yMin < b.yMin ? a.yMin : b.yMin,
+        .xMax = a.xMax > b.xMax ? a.xMax : b.xMax,
+        .yMax = a.yMax > b.yMax ? a.yMax : b.yMax
+    };
+}
+
+static inline uint32_t rectArea (lcd_rect_t rect)
+{
+    return (uint32_t)(rect.xMax - rect.xMin + 1) * (uint32_t)(rect.yMax - rect.yMin + 1);
+}
+
+static void regionAdd (region_t *region, lcd_rect_t rect)
+{
+    uint_fast8_t i = 0, best = 0;
+    uint32_t growth, bestGrowth = UINT32_MAX;
+
+    // Absorb all rectangles touching the new one, restart the scan as the union may reach others
+    while(i < region->count) {
+        if(rectTouches(&rect, &region->rect[i])) {
+            rect = rectUnion(rect, region->rect[i]);
+            region->rect[i] = region->rect[--region->count];
+            i = 0;
+        } else
+            i++;
+    }
+
+    // List full, merge with the rectangle giving the smallest increase in area
+    if(region->count == UILIB_DIRTY_RECTS) {
+        for(i = 0; i < region->count; i++) {
+            if((growth = rectArea(rectUnion(rect, region->rect[i])) - rectArea(region->rect[i])) < bestGrowth) {
+                bestGrowth = growth;
+                best = i;
+            }
+        }
+        rect = rectUnion(rect, region->rect[best]);
+        region->rect[best] = region->rect[--region->count];
+        regionAdd(region, rect);
+    } else
+        region->rect[region->count++] = rect;
+}
+
+static void regionAddPainted (void)
+{
+    lcd_rect_t rect;
+
+    if(getPaintExtent(&rect, true))
+        regionAdd(&painted, rect);
+}
+
+// Clears the screen area of a canvas about to be displayed. If the previous canvas had the same
+// background only the areas drawn on top of it are cleared instead of the full canvas.
+static void canvasClear (Canvas *canvas)
+{
+    lcd_rect_t *rect, area = { canvas->widget.x, canvas->widget.y, canvas->widget.xMax, canvas->widget.yMax };
+
+    regionAddPainted();
+
+    setColor(canvas->widget.bgColor);
+
+    if(background.valid && background.color.value == canvas->widget.bgColor.value && !memcmp(&background.rect, &area, sizeof(lcd_rect_t))) {
+        for(rect = painted.rect; rect < &painted.rect[painted.count]; rect++) {
+            if(rectIntersectsWidget(rect, &canvas->widget))
+                fillRect(rect->xMin < area.xMin ? area.xMin : rect->xMin, rect->yMin < area.yMin ? area.yMin : rect->yMin,
+                          rect->xMax > area.xMax ? area.xMax : rect->xMax, rect->yMax > area.yMax ? area.yMax : rect->yMax);
+        }
+    } else {
+        fillRect(area.xMin, area.yMin, area.xMax, area.yMax);
+        background.valid = true;
+        background.color = canvas->widget.bgColor;
+        background.rect = area;
+    }
+
+    dirty.count = painted.count = 0;
+
+    getPaintExtent(&area, true);
+}
+
+// Clears the dirty areas to the canvas background and repaints the widgets overlapping them
+static void dirtyRepaint (void)
+{
+    lcd_rect_t rect;
+    Widget *widget;
+
+    while(dirty.count) {
+
+        rect = dirty.rect[--dirty.count];
+
+        if(current.canvas) {
+
+            setColor(current.canvas->widget.bgColor);
+            fillRect(rect.xMin, rect.yMin, rect.xMax, rect.yMax);
+
+            widget = current.canvas->widget.firstChild;
+
+            while(widget) {
+                if(!widget->flags.hidden && rectIntersectsWidget(&rect, widget))
+                    widgetPaint(widget, true, true);
+                widget = widget->nextSibling;
+            }
+        }
+    }
+}
+
 inline uint8_t mixColor (uint8_t fg, uint8_t bg, uint8_t alpha)
 {
     return ((fg * alpha) + (bg * (255  - alpha))) >> 8;
@@ -233,8 +466,7 @@ static void widgetPaint (Widget *parent, bool single, bool forceRepaint)
 
                 case WidgetCanvas:
                     current.canvas = (Canvas *)widget;
-                    setColor(current.canvas->widget.bgColor);
-                    fillRect(widget->x, widget->y, widget->xMax, widget->yMax);
+                    canvasClear(current.canvas);
                     break;
 
                 case WidgetFrame:
@@ -717,6 +949,55 @@ Canvas *UILibCanvasGetCurrent (void)
     return current.canvas;
 }
 
+// Returns all widgets of the canvas to the pools, the canvas is kept so its content can be rebuilt.
+void UILibCanvasReset (Canvas *canvas)
+{
+    if(canvas && canvas->widget.type == WidgetCanvas) {
+        while(canvas->widget.firstChild)
+            UILibWidgetDestroy(canvas->widget.firstChild);
+    }
+}
+
+void UILibWidgetDestroy (Widget *widget)
+{
+    if(widget) {
+
+        Widget *parent = widget->parent;
+
+        if(parent) {
+
+            if(widget->prevSibling)
+                widget->prevSibling->nextSibling = widget->nextSibling;
+            else
+                parent->firstChild = widget->nextSibling;
+
+            if(widget->nextSibling)
+                widget->nextSibling->prevSibling = widget->prevSibling;
+            else
+                parent->lastChild = widget->prevSibling;
+        }
+
+        if(widget == (Widget *)current.canvas)
+            current.canvas = NULL;
+
+        widgetRelease(widget);
+    }
+}
+
+bool UILibPoolGetStats (WidgetType type, widget_pool_stats_t *stats)
+{
+    widget_slab_t *slab = slabGet(type);
+
+    if(slab) {
+        stats->capacity = slab->capacity;
+        stats->used     = slab->used;
+        stats->peak     = slab->peak;
+        stats->failed   = slab->failed;
+    }
+
+    return slab != NULL;
+}
+
 void UILibSetEventHandler (Widget *widget, void (*eventHandler)(Widget *self, Event *event))
 {
     if(widget)
@@ -731,6 +1012,14 @@ void UILibWidgetDisplay (Widget *widget)
         widgetPaint(widget, true, true);
 }
 
+// Marks the widget area for repaint at the end of the current UILibProcessEvents() pass,
+// widgets overlapping the area are repainted as well.
+void UILibWidgetInvalidate (Widget *widget)
+{
+    if(widget && current.canvas && widgetGetCanvas(widget) == current.canvas)
+        regionAdd(&dirty, (lcd_rect_t){ widget->x, widget->y, widget->xMax, widget->yMax });
+}
+
 void UILibWidgetEnable (Widget *widget, bool enable)
 {
     if(!widget->flags.hidden) {
@@ -786,24 +1075,93 @@ Label *UILibLabelCreate (Widget *parent, Font *font, RGBColor_t fgColor, uint16_
 
 void UILibLabelClear (Label *label)
 {
+    if(label == NULL) // pool exhausted when created
+        return;
+
     if(label->widget.flags.visible) {
         setColor(label->widget.bgColor);
         fillRect(label->widget.x, label->widget.y, label->widget.xMax, label->widget.yMax);
     }
+
+    label->textStart = label->textEnd = 0;
+}
+
+// Returns the horizontal extent drawStringAligned() will paint for the string
+static void labelTextExtent (Label *label, const char *string, uint16_t *start, uint16_t *end)
+{
+    uint16_t width, x = label->widget.x;
+
+    switch((align_t)label->widget.flags.alignment) {
+
+        case Align_Left:
+            while(*string && x + (width = getCharWidth(label->font, *string)) <= label->widget.x + label->widget.width) {
+                x += width;
+                string++;
+            }
+            *start = label->widget.x;
+            *end = x;
+            return;
+
+        case Align_Right:
+            if((width = getStringWidth(label->font, string)) <= label->widget.width)
+                x += label->widget.width - width;
+            break;
+
+        case Align_Center:
+            if((width = getStringWidth(label->font, string)) <= label->widget.width)
+                x += (label->widget.width - width) >> 1;
+            break;
+
+        default:
+            width = 0;
+            break;
+    }
+
+    *start = x;
+    *end = width <= label->widget.width ? x + width : x;
 }
 
+// Opaque labels draw the text on the label background so only the parts of the previous text
+// extending outside the new one needs to be cleared, for transparent labels all of it is cleared.
 bool UILibLabelDisplay (Label *label, const char *string)
 {
     bool ok = false;
 
-    if(!label->widget.flags.hidden) {
+    if(label && !label->widget.flags.hidden) {
+
+        uint16_t start = 0, end = 0;
 
         label->string = (char *)string;
-        label->widget.flags.visible = true;
 
-        UILibLabelClear(label);
+        if(!label->widget.flags.visible) {
+            label->widget.flags.visible = true;
+            UILibLabelClear(label);
+        }
+
+        if(label->string)
+            labelTextExtent(label, string, &start, &end);
+
+        if(label->textStart < label->textEnd) {
+
+            setColor(label->widget.bgColor);
+
+            if(!label->widget.flags.opaque)
+                fillRect(label->textStart, label->widget.y, label->textEnd - 1, label->widget.yMax);
+            else {
+
+                if(label->textStart < start)
+                    fillRect(label->textStart, label->widget.y, (label->textEnd < start ? label->textEnd : start) - 1, label->widget.yMax);
+
+                if(label->textEnd > end)
+                    fillRect(label->textStart > end ? label->textStart : end, label->widget.y, label->textEnd - 1, label->widget.yMax);
+            }
+        }
+
+        label->textStart = start;
+        label->textEnd = end;
 
         setColor(label->widget.fgColor);
+        setBackgroundColor(label->widget.bgColor);
         ok = label->string && drawStringAligned(label->font, label->widget.x, label->widget.yMax + 1, string, (align_t)label->widget.flags.alignment, label->widget.width, label->widget.flags.opaque);
         setColor(current.canvas->widget.fgColor);
     }
@@ -919,16 +1277,8 @@ bool UILibTextBoxBindValue (TextBox *textbox, void *value, DataType dataType, ch
 {
     if(dataType != DataTypeString) {
 
-        if(textbox->string && textbox->maxLength != maxLength) {
-            free(textbox->string);
-            textbox->string = NULL;
-        }
-
-        if(!textbox->string) {
-            textbox->string = calloc(sizeof(char), maxLength + 1);
-            if(textbox->string)
-                textbox->string[0] = '\0';
-        }
+        textbox->string = textbox->buffer;
+        textbox->string[0] = '\0';
     } else
         textbox->string = value;
 
@@ -938,7 +1288,8 @@ bool UILibTextBoxBindValue (TextBox *textbox, void *value, DataType dataType, ch
         textbox->format   = format == NULL ? (char *)data_format[dataType] : format;
         textbox->widget.flags.noBox = false;
         textbox->widget.flags.disabled = false;
-        textbox->maxLength = maxLength;
+        // Values are formatted to the embedded buffer, longer output is truncated and marked
+        textbox->maxLength = dataType != DataTypeString && maxLength > UILIB_TEXTBOX_LENGTH ? UILIB_TEXTBOX_LENGTH : maxLength;
         textbox->borderColor = DarkGray;
     }
 
@@ -961,19 +1312,19 @@ void UILibButtonSetLabel (Button *button, const char *label)
 {
     if(label) {
 
-        if(button->label && button->widget.flags.allocated) {
-            free(button->label);
-            button->widget.flags.allocated = false;
-        }
-
         if(getStringWidth(button->font, label) > button->widget.width - 6) {
-            if((button->widget.flags.allocated = (button->label = (char *)malloc(strlen(label) + 1)) != NULL)) {
-                strcpy(button->label, label);
-                while(getStringWidth(button->font, button->label) > button->widget.width - 6)
-                    button->label[strlen(button->label) - 1] = '\0';
+            if(label != button->labelBuffer) {
+                strncpy(button->labelBuffer, label, UILIB_BUTTON_LABEL_LENGTH);
+                button->labelBuffer[UILIB_BUTTON_LABEL_LENGTH] = '\0';
             }
-        } else
-            button->label  = (char *)label;
+            button->label = button->labelBuffer;
+            button->widget.flags.allocated = true;
+            while(*button->label && getStringWidth(button->font, button->label) > button->widget.width - 6)
+                button->label[strlen(button->label) - 1] = '\0';
+        } else {
+            button->label = (char *)label;
+            button->widget.flags.allocated = false;
+        }
 
         button->labelx = button->widget.x + (button->widget.flags.alignment == Align_Left ? 3 : (button->widget.width - getStringWidth(button->font, button->label)) / 2);
         button->labely = button->widget.yMax - ((button->widget.height - getFontHeight(button->font)) >> 1) + 4;
@@ -1079,8 +1430,10 @@ List *UILibListCreate (Widget *parent, uint16_t x, uint16_t y, uint16_t width, u
 {
     List *list = (List *)widgetCreate(parent, WidgetList, sizeof(List), x, y, width, rows * 21, eventHandler);
 
-    if(list)
+    if(list) {
         list->group = listGroup--;
+        list->rows = rows;
+    }
 
     return list;
 }
@@ -1106,20 +1459,90 @@ ListElement *UILibListCreateElement (List *list, uint16_t row, const char *label
     return element;
 }
 
+// Labels the elements of a virtual list with the items from topItem and onwards
+static void listRelabel (List *list)
+{
+    void *privateData;
+    const char *label;
+    uint16_t item = list->topItem;
+    Widget *element = list->widget.firstChild;
+
+    while(element) {
+        privateData = NULL;
+        label = item < list->itemCount ? list->getItem(list, item, &privateData) : NULL;
+        element->privateData = privateData;
+        UILibButtonSetLabel((Button *)element, label ? label : "");
+        element = element->nextSibling;
+        item++;
+    }
+}
+
+static bool listScroll (List *list, uint16_t topItem, position_t pos)
+{
+    uint16_t maxTop = list->itemCount > list->rows ? list->itemCount - list->rows : 0;
+
+    if(topItem > maxTop)
+        topItem = maxTop;
+
+    if(topItem == list->topItem)
+        return false;
+
+    list->topItem = topItem;
+    listRelabel(list);
+    UILibPublishEvent((Widget *)list, EventListScrolled, pos, false, NULL);
+
+    return true;
+}
+
+// Turns the list into a virtual list: the elements are reused as a window over itemCount items
+// fetched on demand by getItem, the list scrolls itself when the pointer moves off either end.
+// May be called again as items arrive, elements are only relabeled when the visible window changes.
+void UILibListSetItemSource (List *list, uint16_t itemCount, list_item_ptr getItem)
+{
+    if(list && list->widget.type == WidgetList) {
+
+        bool relabel = getItem != list->getItem || list->topItem + list->rows > (itemCount < list->itemCount ? itemCount : list->itemCount);
+
+        list->getItem = getItem;
+        list->itemCount = getItem ? itemCount : 0;
+
+        if(list->topItem + list->rows > list->itemCount)
+            list->topItem = list->itemCount > list->rows ? list->itemCount - list->rows : 0;
+
+        if(relabel)
+            listRelabel(list);
+    }
+}
+
+// Relabels the visible elements of a virtual list, for when the items changed in place
+void UILibListRefresh (List *list)
+{
+    if(list && list->getItem)
+        listRelabel(list);
+}
+
+bool UILibListScrollTo (List *list, uint16_t topItem)
+{
+    return list && list->getItem && listScroll(list, topItem, (position_t){-1, -1});
+}
+
 Widget *UILibWidgetSetWidth (Widget *widget, uint16_t width)
 {
     if(widget) {
 
+        bool shrink = widget->flags.visible && width < widget->width;
+
+        if(shrink)
+            UILibWidgetInvalidate(widget);
+
         widget->width = width;
         widget->xMax  = widget->x + width - 1;
 
         if(widget->type == WidgetButton)
             UILibButtonSetLabel((Button *)widget, ((Button *)widget)->label);
 
-        if(widget->flags.visible) {
-            //! repaint bg if smaller
+        if(widget->flags.visible && !shrink)
             widgetPaint(widget, true, true);
-        }
     }
 
     return widget;
@@ -1129,16 +1552,19 @@ Widget *UILibWidgetSetHeight (Widget *widget, uint16_t height)
 {
     if(widget) {
 
+        bool shrink = widget->flags.visible && height < widget->height;
+
+        if(shrink)
+            UILibWidgetInvalidate(widget);
+
         widget->height = height;
         widget->yMax   = widget->y + height - 1;
 
-    if(widget->type == WidgetButton)
-        UILibButtonSetLabel((Button *)widget, ((Button *)widget)->label);
+        if(widget->type == WidgetButton)
+            UILibButtonSetLabel((Button *)widget, ((Button *)widget)->label);
 
-        if(widget->flags.visible) {
-            //! repaint bg if smaller
+        if(widget->flags.visible && !shrink)
             widgetPaint(widget, true, true);
-        }
     }
 
     return widget;
@@ -1163,9 +1589,9 @@ bool UILibWidgetHide (Widget *widget, bool hidden)
 
         if(hiddenChanged) {
             if(hidden) {
+                if(widget->flags.visible)
+                    UILibWidgetInvalidate(widget);
                 widget->flags.visible = false;
-                setColor(widget->parent ? widget->parent->bgColor : current.canvas->widget.bgColor);
-                fillRect(widget->x, widget->y, widget->xMax , widget->yMax);
                 //publish event?
             } else
                 widgetPaint(widget, true, true);
@@ -1322,29 +1748,80 @@ bool UILibPublishEvent (Widget *widget, EventReason reason, position_t pos, bool
     return !event.claimed;
 }
 
-event_element_t *addEvent (uint32_t type, int16_t x, int16_t y, bool down)
+// Events may be added from interrupt handlers, a slot is claimed inside a critical section
+// and handed over to UILibProcessEvents() by eventCommit() when the caller has filled it in.
+static event_element_t *eventReserve (uint32_t type, int16_t x, int16_t y, bool down)
 {
     event_element_t *event = NULL;
-
-    while(spin_lock);
-    spin_lock = true;
+    uint32_t state = UILibCriticalEnter();
 
     if(event_head->next != event_tail) {
         event = (event_element_t *)event_head;
+        event->ready = false;
+        event_last = event_head;
+        event_head = event_head->next;
+    } else
+        eventsDropped++;
+
+    UILibCriticalExit(state);
+
+    if(event) {
         event->event.type = type;
-        event->event.tabNav = current.canvas->tabNav;
+        event->event.tabNav = current.canvas ? current.canvas->tabNav : 0;
+        event->event.timestamp = UILibGetTimestamp();
         event->keypress.down = down;
         event->keypress.key = 0;
         event->event.pos.x = x;
         event->event.pos.y = y;
-        event_head = event_head->next;
     }
 
-    spin_lock = false;
-
     return event;
 }
 
+static inline void eventCommit (event_element_t *event)
+{
+    if(event)
+        event->ready = true;
+}
+
+static bool addEvent (uint32_t type, int16_t x, int16_t y, bool down)
+{
+    event_element_t *event = eventReserve(type, x, y, down);
+
+    eventCommit(event);
+
+    return event != NULL;
+}
+
+// Navigator positions are absolute, a move still waiting in the queue is updated with the
+// new position instead of adding another event so that it carries the accumulated delta.
+static void addMoveEvent (int16_t x, int16_t y)
+{
+    bool merged = false;
+    uint32_t state = UILibCriticalEnter();
+
+    if(event_tail != event_head && event_last->ready && event_last->event.type == POINTER_MOVED) {
+        event_last->event.pos.x = x;
+        event_last->event.pos.y = y;
+        merged = true;
+    }
+
+    UILibCriticalExit(state);
+
+    if(!merged)
+        addEvent(POINTER_MOVED, x, y, false);
+}
+
+void UILibGetEventStats (event_stats_t *stats, bool reset)
+{
+    stats->dropped     = eventsDropped;
+    stats->latency     = eventLatency;
+    stats->latency_max = eventLatencyMax;
+
+    if(reset)
+        eventsDropped = eventLatencyMax = 0;
+}
+
 void UILibApplyEnter (Widget *widget)
 {
     static bool lock = false;
@@ -1404,10 +1881,11 @@ bool UILib_ValidateKeypress (TextBox *textbox, char c)
 static void keypressEventHandler (bool keyDown, char key)
 {
     if(key > 0) {
-        event_element_t *event = addEvent(KEY_CHANGED, current.x, current.y, keyDown);
+        event_element_t *event = eventReserve(KEY_CHANGED, current.x, current.y, keyDown);
         if(event) {
             event->keypress.key  = key;
             event->keypress.down = keyDown;
+            eventCommit(event);
         }
     }
 }
@@ -1423,7 +1901,7 @@ static int32_t pointerEventHandler (uint32_t message, int32_t x, int32_t y)
             break;
 
         case WIDGET_MSG_PTR_MOVE:
-            addEvent(POINTER_MOVED, x, y, false);
+            addMoveEvent(x, y);
             break;
 
         case WIDGET_MSG_PTR_UP:
@@ -1432,9 +1910,11 @@ static int32_t pointerEventHandler (uint32_t message, int32_t x, int32_t y)
 
         case WIDGET_MSG_KEY_UP:
         case WIDGET_MSG_KEY_DOWN:;
-            event_element_t *event = addEvent(KEY_CHANGED, x, y, message == WIDGET_MSG_KEY_DOWN);
-            if(event)
+            event_element_t *event = eventReserve(KEY_CHANGED, x, y, message == WIDGET_MSG_KEY_DOWN);
+            if(event) {
                 event->keypress.key = 0xFF;
+                eventCommit(event);
+            }
             break;
     }
 
@@ -1447,7 +1927,11 @@ void remoteEventHandler (remote_cmd_t command)
 {
     position_t pos = current.widget ? widgetGetCPos(current.widget) : (position_t){current.x, current.y};
 
-    event_element_t *event = addEvent(REMOTE_COMMAND, pos.x, pos.y, false);
+    event_element_t *event = eventReserve(REMOTE_COMMAND, pos.x, pos.y, false);
+
+    if(event == NULL)
+        return;
+
     memcpy(&event->remote, &command, sizeof(remote_cmd_t));
 
     switch(event->remote.command) {
@@ -1462,6 +1946,8 @@ void remoteEventHandler (remote_cmd_t command)
             event->event.pos.y -= 1;
             break;
     }
+
+    eventCommit(event);
 }
 
 #endif
@@ -1473,10 +1959,9 @@ void systickHandler (void)
 
 void UILibClaimInputDevice (void)
 {
-    while(spin_lock);
-    spin_lock = true;
+    uint32_t state = UILibCriticalEnter();
     pointerDown = false;
-    spin_lock = false;
+    UILibCriticalExit(state);
 
 #if UILIB_TOUCH_ENABLE
     TOUCH_SetEventHandler(pointerEventHandler);
@@ -1497,7 +1982,10 @@ void UILibProcessEvents (void)
 {
     static bool initOk = false, skipMoves = false;
 
-    bool claimed = false;
+    static uint32_t moveTimestamp = 0;
+
+    bool claimed = false, processed = false;
+    uint32_t state, timestamp = 0;
     event_element_t *head = (event_element_t *)event_head;
 
     if(!initOk) {
@@ -1505,14 +1993,28 @@ void UILibProcessEvents (void)
         setSysTickCallback(systickHandler);
     }
 
-    if(event_tail != head) do {
+    if(event_tail != head && event_tail->ready) do {
 
         int16_t chg;
-        event_element_t *event = (event_element_t *)event_tail;
+        event_element_t eventData, *event = &eventData;
         Widget *widget, *nextWidget;
 
+        // Rate limit moves, a pending move keeps merging new positions until dispatched.
+        // A move with other events queued behind it no longer merges and is dispatched right away.
+        if(event_tail->event.type == POINTER_MOVED) {
+            if(event_tail->next == head && UILibGetTimestamp() - moveTimestamp < UILIB_POINTER_MOVE_INTERVAL * 1000)
+                break;
+            moveTimestamp = UILibGetTimestamp();
+        }
+
+        state = UILibCriticalEnter();
+        eventData  = *(event_element_t *)event_tail;
+        event_tail = event_tail->next; // slot is released to the producers here
+        UILibCriticalExit(state);
+
         claimed     = false;
-        event_tail  = event_tail->next;
+        processed   = true;
+        timestamp   = event->event.timestamp;
         pointerDown = event->keypress.down;
         widget      = current.widget ? current.widget : (Widget *)current.canvas;
 
@@ -1564,11 +2066,21 @@ void UILibProcessEvents (void)
 
                         if(widget->parent->type == WidgetList) {
 
-                            if(widget == widget->parent->lastChild && (event->event.tabNav ? chg > 0 : event->event.pos.y > widget->yMax))
-                                claimed = !UILibPublishEvent(widget->parent, EventListOffEnd, event->event.pos, false, NULL);
+                            List *list = (List *)widget->parent;
+
+                            // Virtual lists scroll by themselves and keep the pointer at the end element
+                            if(widget == widget->parent->lastChild && (event->event.tabNav ? chg > 0 : event->event.pos.y > widget->yMax)) {
+                                if((claimed = list->getItem != NULL))
+                                    listScroll(list, list->topItem + 1, event->event.pos);
+                                else
+                                    claimed = !UILibPublishEvent(widget->parent, EventListOffEnd, event->event.pos, false, NULL);
 
-                            else if(widget == widget->parent->firstChild && (event->event.tabNav ? chg < 0 : event->event.pos.y < widget->y))
-                                claimed = !UILibPublishEvent(widget->parent, EventListOffStart, event->event.pos, false, NULL);
+                            } else if(widget == widget->parent->firstChild && (event->event.tabNav ? chg < 0 : event->event.pos.y < widget->y)) {
+                                if((claimed = list->getItem != NULL))
+                                    listScroll(list, list->topItem ? list->topItem - 1 : 0, event->event.pos);
+                                else
+                                    claimed = !UILibPublishEvent(widget->parent, EventListOffStart, event->event.pos, false, NULL);
+                            }
 
                             if(claimed) {
                                 if(chg == 0) {
@@ -1618,7 +2130,7 @@ void UILibProcessEvents (void)
                 }
                 break;
         }
-    } while(event_tail != head);
+    } while(event_tail != head && event_tail->ready);
 
     if(systicks > systickLimit) {
 
@@ -1632,9 +2144,23 @@ void UILibProcessEvents (void)
         if(!pointerDown && current.canvas && current.canvas->widget.eventHandler)
             UILibPublishEvent((Widget *)current.canvas, EventNullEvent, (position_t){current.x, current.y}, false, NULL);
     }
+
+    if(dirty.count)
+        dirtyRepaint();
+
+    regionAddPainted();
+
+    if(processed) {
+        lcd_busyWait();
+        if((eventLatency = UILibGetTimestamp() - timestamp) > eventLatencyMax)
+            eventLatencyMax = eventLatency;
+    }
 }
 
 __attribute__((weak)) bool NavigatorInit (uint32_t xSize, uint32_t ySize) { return false; }
 __attribute__((weak)) bool NavigatorSetPosition (uint32_t xPos, uint32_t yPos, bool callback) { return true; }
 __attribute__((weak)) uint32_t NavigatorGetYPosition (void) { return 0; }
 __attribute__((weak)) void NavigatorSetEventHandler (on_navigator_event_ptr on_navigator_event) {}
+__attribute__((weak)) uint32_t UILibCriticalEnter (void) { return 0; }
+__attribute__((weak)) void UILibCriticalExit (uint32_t state) {}
+__attribute__((weak)) uint32_t UILibGetTimestamp (void) { return lcd_systicks() * 1000; }
@@ -105,6 +105,7 @@ typedef enum {
     EventPointerLeave,
     EventListOffStart,
     EventListOffEnd,
+    EventListScrolled,
     EventWidgetPainted,
     EventWidgetClose,
     EventWidgetClosed,
@@ -170,10 +171,19 @@ typedef struct Canvas {
 //  RGBColor_t bgColor;
 } Canvas;
 
+struct List;
+
+// Returns the label of a virtual list item, privateData is assigned to the element showing it
+typedef const char *(*list_item_ptr)(struct List *list, uint16_t item, void **privateData);
+
 typedef struct List {
     Widget widget;
     Widget *currentElement;
     uint8_t group;
+    uint16_t rows;
+    uint16_t itemCount;
+    uint16_t topItem;
+    list_item_ptr getItem;
 } List;
 
 typedef struct Button {
@@ -186,6 +196,7 @@ typedef struct Button {
     uint16_t labelx;
     uint16_t labely;
     uint8_t group;
+    char labelBuffer[UILIB_BUTTON_LABEL_LENGTH + 1];
 } Button;
 
 typedef struct {
@@ -197,6 +208,8 @@ typedef struct {
     Widget widget;
     Font *font;
     char *string;
+    uint16_t textStart; // extent of the text currently drawn
+    uint16_t textEnd;
 } Label;
 
 typedef struct {
@@ -216,6 +229,7 @@ typedef struct {
     uint8_t maxLength;
     DataType dataType;
     char *format;
+    char buffer[UILIB_TEXTBOX_LENGTH + 1];
 } TextBox;
 
 typedef struct {
@@ -235,6 +249,19 @@ typedef struct {
 typedef Widget Frame;
 typedef Button ListElement;
 
+typedef struct {
+    uint32_t dropped;       // events lost due to a full queue
+    uint32_t latency;       // us from enqueue of the last event processed until it was handled and painted
+    uint32_t latency_max;
+} event_stats_t;
+
+typedef struct {
+    uint8_t capacity;
+    uint8_t used;
+    uint8_t peak;       // high-water mark
+    uint16_t failed;    // allocations refused since boot
+} widget_pool_stats_t;
+
 extern const position_t currPos;
 
 bool UILibInit (void);
@@ -243,6 +270,7 @@ void UILibSetTabnav (uint8_t delta);
 Canvas *UILibCanvasCreate (uint16_t x, uint16_t y, uint16_t width, uint16_t height, void (*eventHandler)(Widget *self, Event *event));
 void UILibCanvasDisplay (Canvas *canvas);
 Canvas *UILibCanvasGetCurrent (void);
+void UILibCanvasReset (Canvas *canvas);
 
 Frame *UILibFrameCreate (Widget *parent, uint16_t x, uint16_t y, uint16_t width, uint16_t height, void (*eventHandler)(Widget *self, Event *event));
 void UILibFrameClear (Frame *frame);
@@ -251,6 +279,9 @@ Image *UILibImageCreate (Widget *parent, uint16_t x, uint16_t y, uint16_t width,
 
 List *UILibListCreate (Widget *parent, uint16_t x, uint16_t y, uint16_t width, uint16_t rows, void (*eventHandler)(Widget *self, Event *event));
 ListElement *UILibListCreateElement (List *list, uint16_t row, const char *label, void (*eventHandler)(Widget *self, Event *event));
+void UILibListSetItemSource (List *list, uint16_t itemCount, list_item_ptr getItem);
+bool UILibListScrollTo (List *list, uint16_t topItem);
+void UILibListRefresh (List *list);
 
 Button *UILibButtonCreate (Widget *parent, uint16_t x, uint16_t y, const char *label, void (*eventHandler)(Widget *self, Event *event));
 Button *UILibButtonGetSelected (uint32_t group);
@@ -271,6 +302,7 @@ bool UILibTextBoxDisplay (TextBox *textbox);
 bool UILibTextBoxBindValue(TextBox *textbox, void *value, DataType dataType, char *format, const uint8_t maxLength);
 
 void UILibWidgetDisplay (Widget *widget);
+void UILibWidgetInvalidate (Widget *widget);
 bool UILibWidgetHide (Widget *widget, bool hidden);
 void UILibWidgetEnable (Widget *widget, bool enable);
 void UILibWidgetSelect (Widget *widget, uint32_t group);
@@ -279,11 +311,14 @@ void UILibApplyEnter (Widget *widget);
 Widget *UILibWidgetSetWidth (Widget *widget, uint16_t width);
 Widget *UILibWidgetSetHeight (Widget *widget, uint16_t height);
 void UILibSetEventHandler (Widget *widget, void (*eventHandler)(Widget *self, Event *event));
+void UILibWidgetDestroy (Widget *widget);
+bool UILibPoolGetStats (WidgetType type, widget_pool_stats_t *stats);
 
 bool UILib_ValidateKeypress (TextBox *textbox, char c);
 void UILibProcessEvents (void);
 void UILibClaimInputDevice (void);
 bool UILibPublishEvent (Widget *widget, EventReason reason, position_t pos, bool propagate, void *eventdata);
+void UILibGetEventStats (event_stats_t *stats, bool reset);
 
 typedef int32_t (*on_navigator_event_ptr)(uint32_t ulMessage, int32_t lX, int32_t lY);
 
@@ -292,4 +327,9 @@ extern bool NavigatorSetPosition (uint32_t xPos, uint32_t yPos, bool callback);
 extern uint32_t NavigatorGetYPosition (void);
 extern void NavigatorSetEventHandler (on_navigator_event_ptr on_navigator_event);
 
+// Event queue protection and timestamping, to be provided by the HAL
+extern uint32_t UILibCriticalEnter (void);
+extern void UILibCriticalExit (uint32_t state);
+extern uint32_t UILibGetTimestamp (void);
+
 #endif
@@ -0,0 +1,207 @@
+/*
+ * canvas/diagnostics.c - serial link diagnostics
+ *
+ * part of MPG/DRO for grbl on a secondary processor
+ *
+ * v0.0.1 / 2026-10-16 / (c)Io Engineering / Terje
+ */
+
+/*
+
+Copyright (c) 2026, Terje Io
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+* Neither the name of the copyright holder nor the names of its contributors may
+be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../fonts.h"
+#include "../interface.h"
+#include "../UILib/uilib.h"
+#include "../grbl/parser.h"
+
+#include "diagnostics.h"
+
+#define COLUMN 160
+#define ROWS 7
+#define UPDATE_INTERVAL 1000 // ms
+
+static const char *const rowLabel[ROWS] = {
+    "Bytes in:",
+    "Bytes out:",
+    "Lines/s:",
+    "Overflows:",
+    "TX drops:",
+    "Framing errors:",
+    "Latency:"
+};
+
+static const uint16_t pollInterval[] = { 50, 100, 200, 500 }; // ms
+
+static Canvas *canvasDiagnostics = 0, *canvasPrevious;
+static Label *lblValue[ROWS];
+static Button *btnPoll;
+static char value[ROWS][24], pollLabel[24]; // labels keep a reference to the text
+static uint_fast8_t pollIdx = 2;
+static uint32_t nextPoll, nextUpdate, lastUpdate, lastLines;
+
+static grbl_data_t *grbl_data = NULL;
+
+static void showCounters (void)
+{
+    uint_fast8_t idx;
+    uint32_t now = lcd_systicks();
+    const serial_counters_t *counters = serial_getCounters();
+    grbl_link_stats_t *link = grblGetLinkStats();
+
+    sprintf(value[0], "%lu", counters->bytes_in);
+    sprintf(value[1], "%lu", counters->bytes_out);
+    sprintf(value[2], "%lu", now == lastUpdate ? 0 : (counters->lines_in - lastLines) * 1000 / (now - lastUpdate));
+    sprintf(value[3], "%lu", counters->overflows);
+    sprintf(value[4], "%lu", counters->tx_drops);
+    sprintf(value[5], "%lu", counters->framing_errors);
+
+    if(link->reports)
+        sprintf(value[6], "%lu ms, max %lu", link->latency, link->latency_max);
+    else
+        strcpy(value[6], "-");
+
+    for(idx = 0; idx < ROWS; idx++)
+        UILibLabelDisplay(lblValue[idx], value[idx]);
+
+    lastLines = counters->lines_in;
+    lastUpdate = now;
+}
+
+static void showPollInterval (void)
+{
+    sprintf(pollLabel, "Poll every %d ms", pollInterval[pollIdx]);
+    UILibButtonSetLabel(btnPoll, pollLabel);
+}
+
+static void clearChanges (char *line)
+{
+    grbl_data->changed.flags = 0;
+}
+
+/*
+ * Event handlers
+ *
+ */
+
+static void handlerPoll (Widget *self, Event *event)
+{
+    switch(event->reason) {
+
+        case EventPointerUp:
+            UILibButtonFlash((Button *)self);
+            pollIdx = (pollIdx + 1) % (sizeof(pollInterval) / sizeof(uint16_t));
+            showPollInterval();
+            break;
+    }
+}
+
+static void handlerExit (Widget *self, Event *event)
+{
+    switch(event->reason) {
+
+        case EventPointerUp:
+            UILibCanvasDisplay(canvasPrevious);
+            break;
+
+        case EventPointerLeave:
+            event->claimed = event->y < self->y;
+            break;
+    }
+}
+
+static void handlerCanvas (Widget *self, Event *event)
+{
+    uint_fast8_t idx;
+
+    switch(event->reason) {
+
+        case EventNullEvent:
+            if((int32_t)(lcd_systicks() - nextPoll) >= 0) {
+                nextPoll = lcd_systicks() + pollInterval[pollIdx];
+                grblRequestStatus(mapRTC2Legacy(CMD_STATUS_REPORT));
+            }
+            if((int32_t)(lcd_systicks() - nextUpdate) >= 0) {
+                nextUpdate += UPDATE_INTERVAL;
+                showCounters();
+            }
+            break;
+
+        case EventWidgetPainted:
+            setColor(White);
+            drawStringAligned(font_23x16, 0, 22, "Serial link", Align_Center, self->width, false);
+            for(idx = 0; idx < ROWS; idx++)
+                drawStringAligned(font_freepixel_9x17, 0, 45 + idx * 20, rowLabel[idx], Align_Right, COLUMN - 5, false);
+            grbl_data = setGrblReceiveCallback(clearChanges);
+            grblGetLinkStats()->latency_max = 0;
+            lastLines = serial_getCounters()->lines_in;
+            nextPoll = lcd_systicks();
+            nextUpdate = nextPoll + UPDATE_INTERVAL;
+            showCounters();
+            break;
+    }
+}
+
+/*
+ *  end event handlers
+ *
+ */
+
+/*
+ * Public functions
+ *
+ */
+
+void DiagnosticsShowCanvas (void)
+{
+    uint_fast8_t idx;
+
+    if(!canvasDiagnostics) {
+
+        canvasDiagnostics = UILibCanvasCreate(0, 0, 320, 240, handlerCanvas);
+
+        for(idx = 0; idx < ROWS; idx++)
+            lblValue[idx] = UILibLabelCreate((Widget *)canvasDiagnostics, font_freepixel_9x17, White, COLUMN, 45 + idx * 20, 155, NULL);
+
+        btnPoll = UILibButtonCreate((Widget *)canvasDiagnostics, 35, 188, "", handlerPoll);
+        UILibWidgetSetWidth((Widget *)btnPoll, 250);
+        showPollInterval();
+        UILibWidgetSetWidth((Widget *)UILibButtonCreate((Widget *)canvasDiagnostics, 35, 213, "Exit", handlerExit), 250);
+    }
+
+    canvasPrevious = UILibCanvasGetCurrent();
+
+    UILibCanvasDisplay(canvasDiagnostics);
+}
@@ -65,8 +65,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #else
 #define XROW 82
 #endif
-#define YROW XROW + 45
-#define ZROW YROW + 45
+#define ROWSPACING 45
+#define AXISTOP 21      // top of the area available for axis rows when more than three are displayed
+#define AXISBOTTOM 166  // bottom of the same, above the RPM row
 #define POSCOL 50
 #define POSFONT font_arial_48x55
 
@@ -78,6 +79,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define EVENT_KEYUP          (1<<4)
 #define EVENT_JOGMODECHANGED (1<<5)
 
+#define MPG_PLANNER_RESERVE 2 // planner blocks left free when moving with the MPG
+#define SETTING_AUTO_REPORT_INTERVAL 481 // grblHAL, ms between unrequested status reports in MPG mode, 0 = off
+#ifndef AUTO_REPORT_INTERVAL
+#define AUTO_REPORT_INTERVAL 0           // ms, if > 0 the controller setting is changed to this when auto-reporting is available but off
+#endif
+#define AUTO_REPORT_OVERDUE 3            // intervals without a report before polling is resumed
+
 #define MIN(a, b) (((a) > (b)) ? (b) : (a))
 
 typedef struct {
@@ -89,11 +97,14 @@ typedef struct {
     bool visible;
     uint16_t row;
     Label *lblAxis;
-    const char *label;
+    char label[3];
+    RGBColor_t pos_color;
+    char pos_text[25];      // last rendered position, empty when a full repaint is required
 } axis_data_t;
 
 typedef struct {
     uint_fast16_t dro_refresh;
+    uint_fast16_t dro_idle_refresh;
     uint_fast16_t mpg_refresh;
     uint_fast16_t signal_reset;
 } event_counters_t;
@@ -109,6 +120,13 @@ volatile uint_fast8_t event = 0;
 static uint_fast8_t mpg_axis = X_AXIS;
 static float mpg_rpm = 200.0f;
 static bool mpgMove = false, endMove = false;
+static uint_fast8_t mpgQueued = 0; // MPG moves sent since the last Bf: report
+static struct {
+    bool requested;                // SETTING_AUTO_REPORT_INTERVAL has been set
+    bool pending;                  // the setting write is not yet answered
+    uint32_t last;                 // lcd_systicks() when the last report was received
+} autoReport = {0};
+static char mpgBlock[50];          // sent without copying, not to be changed until transmitted
 static bool jogging = false, keyreleased = true, disableMPG = false, mpgReset = false, active = false;
 static bool isLathe = false;
 static float angle = 0.0f;
@@ -121,13 +139,15 @@ static Label *lblDevice, *lblResponseL = NULL, *lblResponseR = NULL, *lblGrblSta
 static lcd_display_t *screen;
 static settings_t *settings = NULL;
 static grbl_info_t *grbl_info = NULL;
-static axis_data_t axis[3] = {
-    { .label = "X:"},
-    { .label = "Y:"},
-    { .label = "Z:"}
-};
+static axis_data_t axis[N_AXIS_MAX] = {0};
+static struct {
+    uint_fast8_t n_axis;
+    Font *font;
+    uint16_t factor_offset;
+} layout = {0};
 static event_counters_t event_interval = {
-    .dro_refresh  = 20,
+    .dro_refresh  = 10,
+    .dro_idle_refresh = 50,
     .mpg_refresh  = 10,
     .signal_reset = 20
 };
@@ -180,6 +200,38 @@ static char *strrepl (char *str, int c, char *str3)
     return str;
 }
 
+// Renders an axis position, only the glyphs that differ from the last rendered string are repainted.
+// If a changed glyph has a different width than the one it replaces the rest of the string is repainted.
+static void drawPosition (uint_fast8_t i, float value, RGBColor_t color)
+{
+    char *text = ftoa(value, "% 9.3f"), *s = text, *last = axis[i].pos_text;
+    uint16_t x = POSCOL, x_end = POSCOL + getStringWidth(layout.font, last);
+    bool repaint = color.value != axis[i].pos_color.value;
+
+    setColor(color);
+
+    while(*s) {
+        if(repaint || *s != *last) {
+            repaint = repaint || *last == '\0' || getCharWidth(layout.font, *s) != getCharWidth(layout.font, *last);
+            x += drawChar(layout.font, x, axis[i].row, *s, true);
+        } else
+            x += getCharWidth(layout.font, *s);
+        if(*last)
+            last++;
+        s++;
+    }
+
+    if(x < x_end) {
+        setColor(canvasMain->widget.bgColor);
+        fillRect(x, axis[i].row - getFontHeight(layout.font), x_end - 1, axis[i].row - 1);
+    }
+
+    setColor(White);
+
+    strcpy(axis[i].pos_text, text);
+    axis[i].pos_color = color;
+}
+
 static void MPG_ResetPosition (bool await)
 {
     mpg_reset();
@@ -193,13 +245,61 @@ static void MPG_ResetPosition (bool await)
     }
 }
 
+// The planner is considered full when the moves sent since the last report may have used up the free blocks reported.
+// Always false if Bf: is not reported.
+static bool MPG_PlannerFull (void)
+{
+    return grbl_data->buffers.reported && grbl_data->buffers.planner <= mpgQueued + MPG_PLANNER_RESERVE;
+}
+
+// Status is polled often while moving and less so otherwise.
+static uint_fast16_t DRO_RefreshInterval (void)
+{
+    switch(grbl_data->grbl.state) {
+
+        case Run:
+        case Jog:
+        case Home:
+            return event_interval.dro_refresh;
+
+        default:
+            return event_interval.dro_idle_refresh;
+    }
+}
+
+// No polling is needed while grblHAL auto-reports, unless reports are overdue or the work offsets are awaited.
+// In alarm state reports are only requested when a response is received, see displayGrblData().
+static bool DRO_PollRequired (void)
+{
+    if(grbl_data->awaitWCO)
+        return true;
+
+#if AUTO_REPORT_INTERVAL > 0
+    const grbl_setting_t *setting;
+
+    // Held back while MPG moves may be unanswered, as far as Bf: tells, so the next response is for the write
+    if(!autoReport.requested && grbl_data->grbl.state == Idle && (mpgQueued == 0 || !grbl_data->buffers.reported) && settings->is_loaded &&
+        (setting = grblGetSetting(SETTING_AUTO_REPORT_INTERVAL)) && setting->integer == 0) {
+        char command[12];
+        autoReport.requested = autoReport.pending = true;
+        sprintf(command, "$%d=%d", SETTING_AUTO_REPORT_INTERVAL, AUTO_REPORT_INTERVAL);
+        grblSendSerial(command);
+    }
+#endif
+
+    if(grbl_data->autoReportingInterval && lcd_systicks() - autoReport.last <= grbl_data->autoReportingInterval * AUTO_REPORT_OVERDUE)
+        return false;
+
+    return grbl_data->grbl.state != Alarm;
+}
+
 static bool MPG_Move (void)
 {
     mpg_t *pos;
     uint32_t velocity = 0;
     float delta_x = 0.0f, delta_y = 0.0f, delta_z = 0.0f;
     bool updated = false;
-    static char buffer[50];
+    char *buffer = mpgBlock;
 
     if(grbl_data->awaitWCO || jogging || grbl_data->alarm || !(grbl_data->grbl.state == Idle || grbl_data->grbl.state == Run))
         return false;
@@ -251,21 +351,19 @@ static bool MPG_Move (void)
     if((updated = delta_x != 0.0f || delta_y != 0.0f || delta_z != 0.0f)) {
 
         sprintf(append(buffer), "F%d", velocity * 50);
-        serial_writeLn(buffer);
+        if(!serial_sendLn(buffer, false))
+            serial_sendLn(buffer, true); // queue full, wait rather than lose the move
+        mpgQueued++;
 //        drawString(font_23x16, 5, 40, buffer, true);
 
-        setColor(Coral);
-
         if(delta_x != 0.0f)
-            drawString(POSFONT, POSCOL, axis[X_AXIS].row, ftoa(axis[X_AXIS].mpg_base - grbl_data->offset.x, "% 9.3f"), true);
+            drawPosition(X_AXIS, axis[X_AXIS].mpg_base - grbl_data->offset.x, Coral);
 
         if(delta_y != 0.0f)
-            drawString(POSFONT, POSCOL, axis[Y_AXIS].row, ftoa(axis[Y_AXIS].mpg_base - grbl_data->offset.y, "% 9.3f"), true);
+            drawPosition(Y_AXIS, axis[Y_AXIS].mpg_base - grbl_data->offset.y, Coral);
 
         if(delta_z != 0.0f)
-            drawString(POSFONT, POSCOL, axis[Z_AXIS].row, ftoa(axis[Z_AXIS].mpg_base - grbl_data->offset.z, "% 9.3f"), true);
-
-        setColor(White);
+            drawPosition(Z_AXIS, axis[Z_AXIS].mpg_base - grbl_data->offset.z, Coral);
 
         if(!leds.run) {
             leds.run = true;
@@ -284,17 +382,14 @@ static void displayBanner (RGBColor_t color)
 
 static void displayPosition (uint_fast8_t i)
 {
-    if(axis[i].visible) {
-        setColor(axis[i].dro_lock ? Yellow : White);
-        drawString(POSFONT, POSCOL, axis[i].row, ftoa(grbl_data->position.values[i] - grbl_data->offset.values[i], "% 9.3f"), true);
-        setColor(White);
-    }
+    if(axis[i].visible)
+        drawPosition(i, grbl_data->position.values[i] - grbl_data->offset.values[i], axis[i].dro_lock ? Yellow : White);
 }
 
 static void setMPGFactorBG (uint_fast8_t i, RGBColor_t color)
 {
     setColor(color);
-    fillRect(268, axis[i].row - 31, screen->Width - 1, axis[i].row - 8);
+    fillRect(268, axis[i].row - layout.factor_offset - 23, screen->Width - 1, axis[i].row - layout.factor_offset);
     setColor(White);
 }
 
@@ -308,7 +403,7 @@ static void displayMPGFactor (uint_fast8_t i, uint_fast8_t mpg_idx)
     if(axis[i].visible) {
         setMPGFactorBG(i, axis[i].mpg_factor == 1.0f ? Black : Red);
         sprintf(buf, "x%d", (uint32_t)axis[i].mpg_factor);
-        drawString(font_23x16, 269, axis[i].row - 10, buf, false);
+        drawString(font_23x16, 269, axis[i].row - layout.factor_offset - 2, buf, false);
     }
 }
 
@@ -321,10 +416,80 @@ static void displayJogMode (jogmode_t jogMode)
 static void displayXMode (const char *mode)
 {
     setColor(mode[0] == '?' ? Red : LawnGreen);
-    drawString(font_23x16, 269, axis[X_AXIS].row - 32, mode, true);
+    drawString(font_23x16, 269, axis[X_AXIS].row - layout.factor_offset - 24, mode, true);
     setColor(White);
 }
 
+static void createAxisLabels (void)
+{
+    uint_fast8_t i;
+
+    for(i = 0; i < N_AXIS_MAX; i++) {
+        if(axis[i].lblAxis) {
+            UILibWidgetDestroy((Widget *)axis[i].lblAxis);
+            axis[i].lblAxis = NULL;
+        }
+        if(axis[i].visible && (axis[i].lblAxis = UILibLabelCreate((Widget *)canvasMain, layout.font, White, 0, axis[i].row, POSCOL - 5, NULL)))
+            axis[i].lblAxis->widget.flags.alignment = Align_Right;
+    }
+}
+
+// Assigns rows to the visible axes. Up to three axes are displayed in the large font,
+// more are compacted into the area above the RPM row with a smaller font.
+// Returns true if the layout changed, the axis labels are then recreated.
+static bool layoutAxes (void)
+{
+    static const char axis_letters[] = "XYZABC";
+
+    uint_fast8_t i, n_axis = grbl_data ? grbl_data->n_axis : 3, n_visible = n_axis;
+    uint16_t row, spacing;
+    Font *font;
+    bool changed;
+
+    if(isLathe && n_axis > Y_AXIS)
+        n_visible--;
+
+    if(n_visible <= 3) {
+        font = POSFONT;
+        row = XROW;
+        spacing = ROWSPACING;
+        layout.factor_offset = 8;
+    } else {
+        spacing = (AXISBOTTOM - AXISTOP) / n_visible;
+        font = spacing > getFontHeight(font_freepixel_17x34) ? font_freepixel_17x34 : font_23x16;
+        row = AXISTOP + spacing;
+        layout.factor_offset = 0;
+    }
+
+    changed = layout.font != font;
+    layout.font = font;
+    layout.n_axis = n_axis;
+
+    for(i = 0; i < N_AXIS_MAX; i++) {
+
+        bool visible = i < n_axis && !(isLathe && i == Y_AXIS);
+        char letter = grbl_data ? grbl_data->axis_letters[i] : axis_letters[i];
+
+        if(visible != axis[i].visible || (visible && (axis[i].row != row || axis[i].label[0] != letter)))
+            changed = true;
+
+        axis[i].visible = visible;
+        axis[i].label[0] = letter;
+        axis[i].label[1] = ':';
+        axis[i].label[2] = '\0';
+
+        if(visible) {
+            axis[i].row = row;
+            row += spacing;
+        }
+    }
+
+    if(changed && canvasMain)
+        createAxisLabels();
+
+    return changed;
+}
+
 static void driver_settings_restore (uint8_t restore_flag)
 {
 
@@ -355,8 +520,8 @@ static void processKeypress (void)
 
         case 'T':
             mpg_axis = mpg_axis == Z_AXIS ? X_AXIS : mpg_axis + 1;
-            for(i = 0; i < 3; i++) {
-                if(axis[i].visible) {
+            for(i = 0; i < layout.n_axis; i++) {
+                if(axis[i].visible && axis[i].lblAxis) {
                     axis[i].lblAxis->widget.fgColor = i == mpg_axis ? Green : White;
                     UILibLabelDisplay(axis[i].lblAxis, axis[i].label);
                 }
@@ -366,8 +531,8 @@ static void processKeypress (void)
 
         case '4':
             mpg_axis = X_AXIS;
-            for(i = 0; i < 3; i++) {
-                if(axis[i].visible) {
+            for(i = 0; i < layout.n_axis; i++) {
+                if(axis[i].visible && axis[i].lblAxis) {
                     axis[i].lblAxis->widget.fgColor = i == mpg_axis ? Green : White;
                     UILibLabelDisplay(axis[i].lblAxis, axis[i].label);
                 }
@@ -377,8 +542,8 @@ static void processKeypress (void)
 
         case '5':
             mpg_axis = Y_AXIS;
-            for(i = 0; i < 3; i++) {
-                if(axis[i].visible) {
+            for(i = 0; i < layout.n_axis; i++) {
+                if(axis[i].visible && axis[i].lblAxis) {
                     axis[i].lblAxis->widget.fgColor = i == mpg_axis ? Green : White;
                     UILibLabelDisplay(axis[i].lblAxis, axis[i].label);
                 }
@@ -388,8 +553,8 @@ static void processKeypress (void)
 
         case '6':
             mpg_axis = Z_AXIS;
-            for(i = 0; i < 3; i++) {
-                if(axis[i].visible) {
+            for(i = 0; i < layout.n_axis; i++) {
+                if(axis[i].visible && axis[i].lblAxis) {
                     axis[i].lblAxis->widget.fgColor = i == mpg_axis ? Green : White;
                     UILibLabelDisplay(axis[i].lblAxis, axis[i].label);
                 }
@@ -675,9 +840,8 @@ static void on_settings_received (settings_t *setn)
     if(settings->is_loaded) {
 
         if((isLathe = settings->mode == 2)) {
-            axis[Y_AXIS].visible = false;
-            axis[Z_AXIS].row = YROW;
-            axis[Z_AXIS].visible = true;
+            if(layoutAxes() && active)
+                UILibCanvasDisplay(canvasMain);
             displayXMode("?");
         }
     }
@@ -700,11 +864,33 @@ static void displayGrblData (char *line)
 {
     uint32_t c;
 
+#if AUTO_REPORT_INTERVAL > 0
+    if(autoReport.pending && (!strcmp(line, "ok") || !strncmp(line, "error:", 6))) {
+        char value[8];
+        autoReport.pending = false;
+        sprintf(value, "%d", AUTO_REPORT_INTERVAL);
+        grblUpdateSetting(SETTING_AUTO_REPORT_INTERVAL, *line == 'o' ? value : NULL);
+    }
+#endif
+
+    if(*line == '<')
+        autoReport.last = lcd_systicks();
+    else if(grbl_data->mpgMode && grbl_data->grbl.state == Alarm)
+        event |= EVENT_DRO; // may have left alarm state, e.g. on unlock or reset
+
     if(endMove || mpgReset)
         grbl_data->changed.offset = true;
 
     if(grbl_data->changed.flags) {
 
+        if(grbl_data->changed.axes && layoutAxes()) {
+            UILibCanvasDisplay(canvasMain); // repaints all fields
+            return;
+        }
+
+        if(grbl_data->changed.buffers)
+            mpgQueued = 0;
+
         if(grbl_data->changed.reset)
             settings->is_loaded = false;
 
@@ -756,21 +942,15 @@ static void displayGrblData (char *line)
                 mpgReset = false;
                 MPG_ResetPosition(false);
             }
-            grbl_data->changed.xpos =
-            grbl_data->changed.ypos =
-            grbl_data->changed.zpos = true;
+            grbl_data->changed.flags |= (1 << layout.n_axis) - 1; // all axis positions
         }
 
         if (!mpgMove) {
 
-            if(grbl_data->changed.xpos)
-                displayPosition(X_AXIS);
-
-            if(grbl_data->changed.ypos)
-                displayPosition(Y_AXIS);
-
-            if(grbl_data->changed.zpos)
-                displayPosition(Z_AXIS);
+            for(c = 0; c < layout.n_axis; c++) {
+                if(grbl_data->changed.flags & (1 << c))
+                    displayPosition(c);
+            }
 
             endMove = false;
         }
@@ -876,7 +1056,9 @@ void DROProcessEvents (void)
                 event &= ~EVENT_KEYDOWN;
         }
 
-        if(event & EVENT_MPG) {
+        // While the planner is full or the previous move is still being transmitted the event is left pending,
+        // the encoder keeps counting and the accumulated distance is sent as a single move when there is room again.
+        if((event & EVENT_MPG) && !((mpgMove && MPG_PlannerFull()) || serial_txBusy(mpgBlock))) {
             event &= ~EVENT_MPG;
             if(MPG_Move())
                 mpgMove = true;
@@ -892,8 +1074,8 @@ void DROProcessEvents (void)
 
         if(event & EVENT_DRO) {
             event &= ~EVENT_DRO;
-            if(!mpgMove && settings->is_loaded)
-                serial_putC(grbl_data->awaitWCO ? CMD_STATUS_REPORT_ALL : mapRTC2Legacy(CMD_STATUS_REPORT)); // Request realtime status from grbl
+            if((!mpgMove || MPG_PlannerFull()) && settings->is_loaded)
+                grblRequestStatus(grbl_data->awaitWCO ? CMD_STATUS_REPORT_ALL : mapRTC2Legacy(CMD_STATUS_REPORT)); // Request realtime status from grbl
         }
 
         if(event & EVENT_JOGMODECHANGED) {
@@ -919,8 +1101,9 @@ static void canvasHandler (Widget *self, Event *uievent)
             isReady = true;
             if(grbl_data->mpgMode) {
                 if(!(--event_count.dro_refresh)) {
-                    event_count.dro_refresh = event_interval.dro_refresh;
-                    event |= EVENT_DRO;
+                    event_count.dro_refresh = DRO_RefreshInterval();
+                    if(DRO_PollRequired())
+                        event |= EVENT_DRO;
                 }
 
                 if(!(--event_count.mpg_refresh)) {
@@ -931,6 +1114,9 @@ static void canvasHandler (Widget *self, Event *uievent)
 
             if(event_count.signal_reset && !(--event_count.signal_reset))
                 event |= EVENT_SIGNALS;
+
+            if(grbl_data->grbl.state == Idle)
+                grblStoreSnapshot(); // blocks while written, only when the $I or $$ responses changed
             break;
 
         case EventPointerUp:
@@ -1001,8 +1187,9 @@ static void canvasHandler (Widget *self, Event *uievent)
             isReady = false;
             setBackgroundColor(canvasMain->widget.bgColor);
             grbl_data = setGrblReceiveCallback(displayGrblData);
-            for(i = 0; i < 3; i++) {
-                if(axis[i].visible) {
+            for(i = 0; i < N_AXIS_MAX; i++) {
+                axis[i].pos_text[0] = '\0'; // canvas background was repainted
+                if(axis[i].visible && axis[i].lblAxis) {
 #ifdef LATHEMODE
                     if(i == X_AXIS)
                         displayXMode("?");
@@ -1061,26 +1248,11 @@ void DROInitCanvas (void)
 
 #ifdef LATHEMODE
     isLathe = true;
-    axis[X_AXIS].row = XROW;
-    axis[X_AXIS].visible = true;
-    axis[Y_AXIS].row = YROW;
-    axis[Y_AXIS].visible = false;
-    axis[Z_AXIS].row = YROW;
-    axis[Z_AXIS].visible = true;
-#else
-    axis[X_AXIS].row = XROW;
-    axis[X_AXIS].visible = true;
-    axis[Y_AXIS].row = YROW;
-    axis[Y_AXIS].visible = true;
-    axis[Z_AXIS].row = ZROW;
-    axis[Z_AXIS].visible = true;
 #endif
 
-    axis[X_AXIS].label = "X:";
-    axis[Y_AXIS].label = "Y:";
-    axis[Z_AXIS].label = "Z:";
+    layoutAxes();
 
-    i = 3;
+    i = N_AXIS_MAX;
     do {
         i--;
         axis[i].mpg_factor = mpgFactors[axis[i].mpg_idx];
@@ -1094,8 +1266,6 @@ void DROShowCanvas (lcd_display_t *lcd_screen)
 
     if(!canvasMain) {
 
-        uint_fast8_t i;
-
         nav_midpos = screen->Height / 2;
         canvasMain = UILibCanvasCreate(0, 0, screen->Width, screen->Height, canvasHandler);
         canvasMain->widget.bgColor = Black;
@@ -1103,12 +1273,7 @@ void DROShowCanvas (lcd_display_t *lcd_screen)
         lblDevice = UILibLabelCreate((Widget *)canvasMain, font_23x16, White, 2, 20, screen->Width - 4, NULL);
         lblDevice->widget.flags.alignment = Align_Center;
 
-        for(i = 0; i < 3; i++) {
-            if(axis[i].visible) {
-                axis[i].lblAxis = UILibLabelCreate((Widget *)canvasMain, POSFONT, White, 0, axis[i].row, POSCOL - 5, NULL);
-                axis[i].lblAxis->widget.flags.alignment = Align_Right;
-            }
-        }
+        createAxisLabels();
 
         lblRPM = UILibLabelCreate((Widget *)canvasMain, font_freepixel_17x34, White, 60, RPMROW, 100, NULL);
         lblJogMode = UILibLabelCreate((Widget *)canvasMain, font_23x16, White, 265, RPMROW - 3, 53, NULL);
@@ -46,6 +46,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../UILib/uilib.h"
 #include "../grbl/parser.h"
 
+#include "diagnostics.h"
+
 static Canvas *canvasUtils = 0, *canvasPrevious;
 static Label *lblResponseL = NULL, *lblResponseR = NULL;
 static Button *btnLimit;
@@ -98,6 +100,17 @@ static void handlerOverride (Widget *self, Event *event)
     }
 }
 
+static void handlerDiagnostics (Widget *self, Event *event)
+{
+    switch(event->reason) {
+
+        case EventPointerUp:
+            UILibButtonFlash((Button *)self);
+            DiagnosticsShowCanvas();
+            break;
+    }
+}
+
 static void handlerExit (Widget *self, Event *event)
 {
     switch(event->reason) {
@@ -148,6 +161,19 @@ static void showResponse (char *line)
     }
 }
 
+// The title and receive callback are set on every paint as the diagnostics canvas returns here
+static void handlerCanvas (Widget *self, Event *event)
+{
+    switch(event->reason) {
+
+        case EventWidgetPainted:
+            grbl_data = setGrblReceiveCallback(showResponse);
+            setColor(White);
+            drawStringAligned(font_23x16, 0, 22, "grbl Utilities", Align_Center, self->width, false);
+            break;
+    }
+}
+
 /*
  * Public functions
  *
@@ -157,7 +183,7 @@ void GRBLUtilsShowCanvas (void)
 {
     if(!canvasUtils) {
 
-        canvasUtils = UILibCanvasCreate(0, 0, 320, 240, NULL);
+        canvasUtils = UILibCanvasCreate(0, 0, 320, 240, handlerCanvas);
 
         UILibWidgetSetWidth((Widget *)UILibButtonCreate((Widget *)canvasUtils, 35, 40, "Exit", handlerExit), 250);
         UILibWidgetSetWidth((Widget *)UILibButtonCreate((Widget *)canvasUtils, 35, 65, "Reset", handlerReset), 250);
@@ -166,6 +192,7 @@ void GRBLUtilsShowCanvas (void)
         UILibWidgetSetWidth((Widget *)btnLimit, 250);
         btnLimit->hltColor = Red;
         btnLimit->group = 1;
+        UILibWidgetSetWidth((Widget *)UILibButtonCreate((Widget *)canvasUtils, 35, 140, "Serial link", handlerDiagnostics), 250);
         lblResponseL = UILibLabelCreate((Widget *)canvasUtils, font_freepixel_9x17, White, 5, 239, 200, NULL);
         lblResponseR = UILibLabelCreate((Widget *)canvasUtils, font_23x16, Red, 210, 239, 108, NULL);
         lblResponseR->widget.flags.alignment = Align_Right;
@@ -174,7 +201,4 @@ void GRBLUtilsShowCanvas (void)
     canvasPrevious = UILibCanvasGetCurrent();
 
     UILibCanvasDisplay(canvasUtils);
-    grbl_data = setGrblReceiveCallback(showResponse);
-    setColor(White);
-    drawStringAligned(font_23x16, 0, 22, "grbl Utilities", Align_Center, 320, false);
 }
@@ -49,57 +49,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define LISTELEMENTS 8
 
 static bool exit = false;
-static uint_fast16_t list_index = 0;
 static Canvas *canvasSDCard = 0, *canvasPrevious;
 static List *listPrograms;
 static sd_files_t *sd_files = NULL;
-static sd_file_t *sd_file = NULL;
 
-static inline int32_t max (int32_t a, int32_t b)
+static const char *getFileItem (List *list, uint16_t item, void **privateData)
 {
-	return a > b ? a : b;
-}
-
-static sd_file_t *get_file (uint_fast16_t idx)
-{
-    if(sd_files == NULL || sd_files->num_files == 0)
-        return NULL;
-
-    if(idx == 0)
-        return sd_files->files;
-
-    sd_file_t *file = sd_files->files;
+    sd_file_t *sd_file = grblGetSDFile(sd_files, item);
 
-    if(idx < sd_files->num_files) {
-        if(file) do {
-            file = file->next;
-        } while(--idx && file);
-    }
-
-    return file;
-}
-
-static bool listRefresh (int index)
-{
-	Widget *element = listPrograms->widget.firstChild;
-
-	if(sd_files == NULL || (index < 0 || index > max(0, sd_files->num_files - LISTELEMENTS)))
-		return false;
-
-	index = max(0, index); //??
-    list_index = index;
-
-	while(element) {
-		sd_file                    = get_file(index);
-		element->privateData       = sd_file;
-//		element->flags.selected    = program == (UImode == UIMode_DAB ? DABLastPlayed : presetLastPlayed);
-		element->flags.highlighted = false;
-		UILibButtonSetLabel((Button *)element, sd_file ? sd_file->name + 1 : "");
-		element = element->nextSibling;
-		index++;
-	}
+    *privateData = sd_file;
 
-	return true;
+    return sd_file ? sd_file->name + 1 : NULL;
 }
 
 /*
@@ -111,7 +71,13 @@ static void on_sd_files_received (sd_files_t *files)
 {
     sd_files = files;
 
-    listRefresh(0);
+    UILibListSetItemSource(listPrograms, sd_files->num_files, getFileItem);
+
+    // Partial listings are shown in received order, sorting may move the rows in view so is done once complete
+    if(files->complete) {
+        grblSortSDFiles(sd_files, SDSort_Name);
+        UILibListRefresh(listPrograms);
+    }
 }
 
 static void handlerSelectList (Widget *self, Event *event)
@@ -126,22 +92,6 @@ static void handlerSelectList (Widget *self, Event *event)
 	}
 }
 
-static void handlerProgramList (Widget *self, Event *event)
-{
-	switch(event->reason) {
-
-		case EventListOffStart:
-            listRefresh(list_index - 1);
-			event->claimed = true;
-			break;
-
-		case EventListOffEnd:
-			listRefresh(list_index + 1);
-			event->claimed = true;
-			break;
-	}
-}
-
 static void handlerCanvas (Widget *self, Event *event)
 {
     switch(event->reason) {
@@ -173,7 +123,7 @@ void SDCardShowCanvas (Canvas *previous)
     if(!canvasSDCard) {
 
         canvasSDCard = UILibCanvasCreate(0, 0, 320, 240, handlerCanvas);
-		listPrograms = UILibListCreate((Widget *)canvasSDCard, 10, 40, 300, LISTELEMENTS, handlerProgramList);
+		listPrograms = UILibListCreate((Widget *)canvasSDCard, 10, 40, 300, LISTELEMENTS, NULL);
 		uint_fast8_t i;
 		for(i = 0; i < LISTELEMENTS; i++)
 			UILibListCreateElement(listPrograms, i, "", handlerSelectList);
@@ -182,6 +132,8 @@ void SDCardShowCanvas (Canvas *previous)
     exit = false;
     canvasPrevious = previous; //UILibCanvasGetCurrent();
 
+    UILibListSetItemSource(listPrograms, 0, NULL);
+
     UILibCanvasDisplay(canvasSDCard);
 
     setColor(White);
@@ -53,6 +53,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define PASSROW 55
 #define XROW 85
 #define ZROW 110
+#define LINEROW 180
+#define STREAM_QUEUE_SIZE 32 // max number of blocks awaiting a response
+#ifndef ASCII_EOL
+#define ASCII_EOL "\r\n"      // appended by serial_writeLn()
+#endif
 
 typedef enum {
     JobInit = 0,
@@ -65,10 +70,25 @@ static volatile uint32_t awaitResponse;
 static uint_fast8_t rqdly;
 static Canvas *canvasSender = NULL, *canvasPrevious;
 static Button *btnCancel;
-static Label *lblXPos, *lblZPos, *lblPass;
+static Label *lblXPos, *lblZPos, *lblPass, *lblLine;
 static leds_t leds;
 static job_state_t jobState;
 static gcode_t *(*getGCode)(bool ok, char *string) = NULL;
+static grbl_data_t *grbl = NULL;
+
+// Character counting protocol: blocks are sent as long as they fit in grbl's RX buffer,
+// each ok or error is matched to the oldest block sent.
+static struct {
+    uint_fast16_t rx_size;              // usable part of grbl's RX buffer
+    uint_fast16_t bytes;                // sent and not yet acknowledged, including line terminators
+    uint_fast8_t head, tail;
+    uint_fast8_t count;
+    bool sync;                          // a $ command is in flight, it has to complete before sending more
+    bool halted;                        // an error was reported, no more blocks are sent
+    uint32_t sent, acked;
+    gcode_t *next;                      // block fetched that did not fit
+    uint16_t length[STREAM_QUEUE_SIZE];
+} stream;
 
 /*
  * Event handlers
@@ -81,16 +101,92 @@ static void keypressEventHandler (bool keyDown, char key)
         keyDownEvent = keyDown;
 }
 
+static void streamStart (void)
+{
+    memset(&stream, 0, sizeof(stream));
+    stream.rx_size = grblGetRxBufferSize() - 1;
+    jobState = JobInit;
+}
+
+// Sends blocks until grbl's RX buffer is full. $ commands are not streamed since some
+// of them write to EEPROM or change state that following blocks depend on: they are
+// sent when nothing is in flight and further blocks are held back until they complete.
+static void streamFill (void)
+{
+    uint_fast16_t length;
+
+    while(!stream.halted && !stream.sync && stream.count < STREAM_QUEUE_SIZE) {
+
+        // Keep the RX buffer from filling up behind a full planner so a feed hold or cancel is not delayed
+        if(grbl && grbl->buffers.reported && grbl->buffers.planner == 0 && stream.count > 0)
+            break;
+
+        if(stream.next == NULL) {
+
+            if(jobState == JobComplete)
+                break;
+
+            stream.next = getGCode(jobState == JobInit, NULL);
+            jobState = stream.next->complete ? JobComplete : JobRun;
+
+            if(stream.next->complete) {
+                stream.next = NULL;
+                break;
+            }
+        }
+
+        length = strlen(stream.next->block) + strlen(ASCII_EOL);
+
+        if(stream.next->block[0] == '$' ? stream.bytes > 0 : stream.bytes + length > stream.rx_size && stream.count > 0)
+            break;
+
+        stream.sync = stream.next->block[0] == '$';
+        stream.bytes += length;
+        stream.length[stream.head] = (uint16_t)length;
+        stream.head = (stream.head + 1) % STREAM_QUEUE_SIZE;
+        stream.count++;
+        stream.sent++;
+
+        grblSendSerial(stream.next->block);
+        stream.next = NULL;
+    }
+}
+
+// Progress is counted from the blocks acknowledged, the line number reported by Ln:
+// is from the program's own N words and is only shown along with it.
+static void streamProgress (grbl_data_t *grbl_data)
+{
+    static char progress[30]; // kept by the label
+
+    if(grbl_data->line_number)
+        sprintf(progress, "%lu/%lu N%lu", stream.acked, stream.sent, grbl_data->line_number);
+    else
+        sprintf(progress, "%lu of %lu", stream.acked, stream.sent);
+
+    UILibLabelDisplay(lblLine, progress);
+}
+
 static void sendGCode (bool ok, grbl_data_t *grbl_data)
 {
-    if(ok && jobState != JobComplete) {
+    bool error = !ok && !strncmp(grbl_data->block, "error:", 6);
 
-        gcode_t *gcode = getGCode(jobState == JobInit, grbl_data->block);
+    if((ok || error) && stream.count) {
 
-        jobState = gcode->complete ? JobComplete : JobRun;
+        stream.bytes -= stream.length[stream.tail];
+        stream.tail = (stream.tail + 1) % STREAM_QUEUE_SIZE;
+        stream.count--;
+        stream.acked++;
+        stream.sync = false;
+
+        if(error && !stream.halted) {
+            static char msg[40]; // kept by the label
+            stream.halted = true;
+            sprintf(msg, "Block %lu: %.20s", stream.acked, grbl_data->block);
+            UILibLabelDisplay(lblPass, msg);
+        }
 
-        if(!gcode->complete)
-            grblSendSerial(gcode->block);
+        streamFill();
+        streamProgress(grbl_data);
 
         return;
     }
@@ -101,13 +197,19 @@ static void sendGCode (bool ok, grbl_data_t *grbl_data)
         leds.hold = grbl_data->grbl.state == Hold;
         leds_setState(leds);
 
-        if(jobState == JobComplete && grbl_data->grbl.state == Idle)
+        if(jobState == JobComplete && stream.count == 0 && grbl_data->grbl.state == Idle)
             UILibCanvasDisplay(canvasPrevious);
 
 //            UILibLabelDisplay(txtStatus,  grbl_data->grbl.state_text);
 
     }
 
+    if(grbl_data->changed.buffers && !stream.halted)
+        streamFill(); // the planner may have room again
+
+    if(grbl_data->changed.line_number)
+        streamProgress(grbl_data);
+
     if(grbl_data->grbl.state == Run) {
 
         if(grbl_data->changed.message)
@@ -136,6 +238,8 @@ static void sendGCode (bool ok, grbl_data_t *grbl_data)
 
 static void checkGRBL (bool ok, grbl_data_t *grbl_data)
 {
+    grbl = grbl_data;
+
     if(!(grblReady = ok))
         UILibLabelDisplay(lblPass, grbl_data->block);
 }
@@ -171,13 +275,13 @@ static void handlerCanvas (Widget *self, Event *event)
                         UILibLabelDisplay(lblPass, "Sending...");
                         setGrblTransmitCallback(sendGCode);
                         setKeyclickCallback2(keypressEventHandler, false);
-                        jobState = JobInit;
                         keyDownEvent = false;
                         leds = leds_getState();
-                        sendGCode(true, NULL); // Send first block to start transmission
+                        streamStart();
+                        streamFill(); // Fill grbl's RX buffer to start transmission
                     }
                 } else if(grblReady)
-                    serial_putC(mapRTC2Legacy(CMD_STATUS_REPORT)); // Request realtime status from grbl
+                    grblRequestStatus(mapRTC2Legacy(CMD_STATUS_REPORT)); // Request realtime status from grbl
                 rqdly = 20;
             }
 
@@ -211,6 +315,7 @@ static void handlerCanvas (Widget *self, Event *event)
             drawStringAligned(font_23x16, 0, 22, "GCode Sender", Align_Center, self->width, false);
             drawString(font_23x16, 10, XROW, "X:", false);
             drawString(font_23x16, 10, ZROW, "Z:", false);
+            drawString(font_23x16, 10, LINEROW, "Line:", false);
             UILibLabelDisplay(lblPass, "Syncing...");
             rqdly = 20;
             grblReady = false;
@@ -222,6 +327,7 @@ static void handlerCanvas (Widget *self, Event *event)
         case EventWidgetClose:
             UILibLabelDisplay(lblXPos, "");
             UILibLabelDisplay(lblZPos, "");
+            UILibLabelDisplay(lblLine, "");
             setGrblTransmitCallback(NULL);
             setKeyclickCallback(NULL, false);
             if(grblReady)
@@ -255,6 +361,8 @@ void SenderShowCanvas (gcode_t *(*fn)(bool ok, char *line))
         lblZPos = UILibLabelCreate((Widget *)canvasSender, font_23x16, White, 40, ZROW, 100, NULL);
         lblZPos->widget.flags.alignment = Align_Right;
 
+        lblLine = UILibLabelCreate((Widget *)canvasSender, font_23x16, White, 70, LINEROW, 240, NULL);
+
         btnCancel = UILibButtonCreate((Widget *)canvasSender, 35, 130, "Cancel", handlerCancel);
         UILibWidgetSetWidth((Widget *)btnCancel, 250);
     }
@@ -90,12 +90,14 @@ static Canvas *canvasThreading = 0, *canvasPrevious;
 
 static confirm_line_t *getLine (void)
 {
-    static confirm_line_t *line = NULL;
+    static char string[50];
+    static confirm_line_t confirm_line = {
+        .string = string
+    };
 
-    if(!line) {
-        line          = malloc(sizeof(confirm_line_t));
-        line->string  = malloc(50);
-        line->counter = 0;
+    confirm_line_t *line = &confirm_line;
+
+    if(line->counter == 0) {
         line->font    = font_23x16;
         line->bgColor = PaleGreen;
         line->fgColor = Black;
@@ -136,8 +138,7 @@ static confirm_line_t *getLine (void)
             break;
 
         default:
-            free(line->string);
-            free(line);
+            line->counter = 0;
             line = NULL;
             break;
     }
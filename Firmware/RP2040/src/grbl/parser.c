@@ -38,9 +38,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <assert.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
@@ -80,6 +82,7 @@ const RGBColor_t grblStateColor[NUMSTATES] = {
 
 static grbl_data_t grbl_data = {
     .n_axis               = 3,
+    .axis_letters         = "XYZABC",
     .changed              = (uint32_t)-1,
     .position             = {0.0f, 0.0f, 0.0f},
     .offset               = {0.0f, 0.0f, 0.0f},
@@ -105,6 +108,8 @@ static grbl_data_t grbl_data = {
 
 #ifdef PARSER_SERIAL_ENABLE
 static void parseData (char *block);
+static void parse_settings (char *line);
+static void fetchSettings (void);
 static void (*grblTransmitCallback)(bool ok, grbl_data_t *grbl_data) = NULL;
 static grbl_settings_received_ptr on_settings_received = NULL;
 #endif
@@ -115,6 +120,7 @@ static struct {
     grbl_settings_received_ptr on_settings_received;
     grbl_info_received_ptr on_info_received;
     grbl_sd_files_received_ptr on_sd_files_received;
+    grbl_setting_changed_ptr on_setting_changed;
     grbl_callback_ptr on_line_received;
 #endif
 } grbl_event = {
@@ -123,6 +129,7 @@ static struct {
     .on_settings_received = NULL,
     .on_info_received = NULL,
     .on_sd_files_received = NULL,
+    .on_setting_changed = NULL,
     .on_line_received = parseData
 #endif
 };
@@ -161,9 +168,8 @@ grbl_data_t *setGrblReceiveCallback (grbl_callback_ptr fn)
 #ifdef PARSER_SERIAL_ENABLE
     grblTransmitCallback = NULL;
 #endif
-    grbl_data.changed.flags = (uint32_t)-1;
+    grbl_data.changed.flags = (uint64_t)-1;
     grbl_data.changed.await_ack = grbl_data.changed.reset = false;
-    grbl_data.changed.unassigned = 0;
 
     return &grbl_data;
 }
@@ -205,6 +211,77 @@ static grbl_info_t grbl_info = {
 
 static sd_files_t sd_files = {0};
 
+// All settings reported by $$, sorted by id. String values are stored in a pool,
+// offset 0 is reserved for the empty string.
+static struct {
+    bool valid;
+    uint8_t pass;                           // incremented for each $$ response
+    uint_fast16_t count;
+    uint_fast16_t pool_used;
+    grbl_setting_t table[GRBL_SETTINGS_MAX];
+    char pool[GRBL_SETTINGS_POOL_SIZE];
+} settings_cache = {
+    .pool_used = 1
+};
+
+#define STATUS_REQUEST_TIMEOUT 1000 // ms before an unanswered status request is considered lost
+
+static grbl_link_stats_t link_stats = {0};
+static struct {
+    bool pending;
+    uint32_t sent;
+} status_request = {0};
+
+#define SNAPSHOT_MAGIC 0x47534E33 // GSN3
+#define CHECKSUM_INIT 2166136261UL
+
+// Snapshot of the $I and $$ responses kept in non-volatile storage, keyed by a checksum of the $I response
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t info_checksum;
+    uint32_t settings_checksum;
+    grbl_info_t info;
+    settings_t settings;
+    uint16_t count;
+    uint16_t pool_used;
+    grbl_setting_t table[GRBL_SETTINGS_MAX];
+    char pool[GRBL_SETTINGS_POOL_SIZE];
+    uint32_t checksum;
+} snapshot_t;
+
+static_assert(sizeof(snapshot_t) <= GRBL_SNAPSHOT_SIZE_MAX, "snapshot does not fit in non-volatile storage");
+
+static struct {
+    bool checked;                           // non-volatile storage has been read
+    bool verify;                            // info and settings are from the snapshot and not yet verified
+    bool save;                              // to be written by grblStoreSnapshot()
+    uint32_t info_checksum;                 // of the stored snapshot
+    uint32_t settings_checksum;             // of the stored snapshot
+    grbl_info_received_ptr on_info_received;
+} snapshot = {0};
+
+static snapshot_t nvs_buffer;
+static uint32_t info_checksum = 0;          // of the bracketed lines of the last $I response, 0 if none received
+static uint32_t info_hash;                  // of the $I response being received
+
+// Fixed point shadows of the decimal values in grbl_data, used for change detection
+static struct {
+    int32_t position[N_AXIS_MAX];
+    int32_t offset[N_AXIS_MAX];
+    int32_t feed_rate;
+    int32_t rpm_programmed;
+    int32_t rpm_actual;
+} fixed = {0};
+
+// Fields seen in the real-time report being parsed
+static struct {
+    bool pins;
+    bool positions;
+    bool line_number;
+    bool buffers;
+} report = {0};
+
 static void processReply (char *line)
 {
     grblTransmitCallback(strcmp(line, "ok") == 0, &grbl_data);
@@ -221,375 +298,653 @@ void grblSerialFlush (void)
     serial_RxCancel();
 }
 
-static bool parseDecimal (float *value, char *data)
+// Status report fields are separated by '|' and the report is terminated by '>',
+// '\0' is included for truncated lines.
+static inline bool isFieldEnd (char c)
 {
-    bool changed;
+    return c == '|' || c == '>' || c == '\0';
+}
 
-    float val = (float)atof(data);
-    if((changed = val != *value))
-        *value = val;
+// Skips a ',' value separator, returns false if none
+static inline bool nextValue (char **data)
+{
+    bool ok;
 
-    return changed;
+    if((ok = **data == ','))
+        (*data)++;
+
+    return ok;
 }
 
-static bool parseInt (int32_t *value, char *data)
+static inline bool isDigit (char c)
 {
-    bool changed;
+    return c >= '0' && c <= '9';
+}
 
-    int32_t val = (int32_t)atoi(data);
-    if((changed = val != *value))
-        *value = val;
+// Parses grbls decimal format, -?\d+(\.\d+)?, to an integer count of 1/FIXED_SCALE units.
+// Decimals beyond FIXED_DECIMALS are truncated, mm values has 3 and inch values 4 decimals.
+static bool parseFixed (int32_t *value, char **data)
+{
+    char *s = *data;
+    bool negative, digits = false;
+    uint32_t ipart = 0, fpart = 0;
+    uint_fast8_t decimals = FIXED_DECIMALS;
+
+    if((negative = *s == '-') || *s == '+')
+        s++;
+
+    while(isDigit(*s)) {
+        ipart = ipart * 10 + (*s++ - '0');
+        digits = true;
+    }
+
+    if(*s == '.') {
+        s++;
+        while(isDigit(*s)) {
+            if(decimals) {
+                fpart = fpart * 10 + (*s - '0');
+                decimals--;
+            }
+            s++;
+            digits = true;
+        }
+    }
+
+    if(!digits)
+        return false;
+
+    while(decimals--)
+        fpart *= 10;
+
+    *value = (int32_t)(ipart * FIXED_SCALE + fpart);
+    if(negative)
+        *value = -*value;
+    *data = s;
+
+    return true;
+}
+
+// Values are compared in fixed point, the float copy is only updated on change
+static bool parseDecimal (float *value, int32_t *fixed, char **data)
+{
+    bool changed = false;
+    int32_t val;
+
+    if(parseFixed(&val, data) && (changed = val != *fixed)) {
+        *fixed = val;
+        *value = (float)val / (float)FIXED_SCALE;
+    }
 
     return changed;
 }
 
-static bool parseUint (uint32_t *value, char *data)
+static bool parseUint (uint32_t *value, char **data)
 {
     bool changed;
+    char *s = *data;
+    uint32_t val = 0;
+
+    if(!isDigit(*s))
+        return false;
+
+    while(isDigit(*s))
+        val = val * 10 + (*s++ - '0');
 
-    uint32_t val = (uint32_t)atoi(data);
+    *data = s;
     if((changed = val != *value))
         *value = val;
 
     return changed;
 }
 
-static void parsePositions (char *data)
+// Copies a field to dest, truncated to size, and flags a change if the content differs
+static char *parseString (char *dest, size_t size, char *data, bool *changed)
 {
-    char *next;
+    size_t idx = 0;
+
+    *changed = false;
+
+    while(!isFieldEnd(*data)) {
+        if(idx < size - 1) {
+            if(dest[idx] != *data) {
+                dest[idx] = *data;
+                *changed = true;
+            }
+            idx++;
+        }
+        data++;
+    }
+
+    if(dest[idx] != '\0') {
+        dest[idx] = '\0';
+        *changed = true;
+    }
+
+    return data;
+}
+
+static char *parseState (char *data, grbl_t *grbl, bool *changed)
+{
+    char *name = data;
+    uint_fast8_t len;
+    uint32_t substate = 0;
+
+    *changed = false;
+
+    while(!isFieldEnd(*data) && *data != ':')
+        data++;
+
+    len = data - name;
 
-    next = strchr(data, ',');
-    *next++ = '\0';
+    if(*data == ':') {
+        data++;
+        parseUint(&substate, &data);
+    }
 
-    if(parseDecimal(&grbl_data.position.x, data))
-        grbl_data.changed.xpos = true;
+    if(len < sizeof(grbl->state_text) && (strncmp(grbl->state_text, name, len) || grbl->state_text[len] != '\0')) {
+        uint_fast8_t state = 0;
+        while(state < NUMSTATES) {
+            if(!strncmp(name, grblState[state], len) && grblState[state][len] == '\0') {
+                *changed = true;
+                grbl->state = (grbl_state_t)state;
+                grbl->substate = substate;
+                grbl->state_color = grblStateColor[state];
+                memcpy(grbl->state_text, name, len);
+                grbl->state_text[len] = '\0';
+                break;
+            }
+            state++;
+        }
+    }
 
-    data = next;
-    next = strchr(data, ',');
-    *next++ = '\0';
+    if(!*changed && grbl->substate != substate) {
+        *changed = true;
+        grbl->substate = substate;
+    }
 
-    if(parseDecimal(&grbl_data.position.y, data))
-        grbl_data.changed.ypos = true;
+    return data;
+}
 
-    if(parseDecimal(&grbl_data.position.z, next))
-        grbl_data.changed.zpos = true;
+static void setAxisCount (uint_fast8_t n_axis)
+{
+    if(n_axis != grbl_data.n_axis) {
+        grbl_data.n_axis = n_axis;
+        grbl_data.changed.axes = true;
+    }
 }
 
-static void parseOffsets (char *data)
+// The number of axes reported is taken from the number of values in the position field
+static char *parsePositions (char *data)
 {
-    if(grbl_data.useWPos) {
+    uint_fast8_t idx = 0;
 
-        grbl_data.changed.offset = grbl_data.offset.x != 0.0f ||
-                                    grbl_data.offset.y != 0.0f ||
-                                     grbl_data.offset.z != 0.0f;
+    do {
+        if(parseDecimal(&grbl_data.position.values[idx], &fixed.position[idx], &data))
+            grbl_data.changed.flags |= 1 << idx;
+    } while(++idx < N_AXIS_MAX && nextValue(&data));
 
-        grbl_data.offset.x =
-        grbl_data.offset.y =
-        grbl_data.offset.z = 0.0f;
+    setAxisCount(idx);
 
-    } else {
+    return data;
+}
 
-        char *next;
+static char *parseOffsets (char *data)
+{
+    if(grbl_data.useWPos) {
 
-        next = strchr(data, ',');
-        *next++ = '\0';
+        uint_fast8_t idx = N_AXIS_MAX;
 
-        if(parseDecimal(&grbl_data.offset.x, data))
-            grbl_data.changed.offset = true;
+        do {
+            if(fixed.offset[--idx] != 0) {
+                grbl_data.changed.offset = true;
+                grbl_data.offset.values[idx] = 0.0f;
+                fixed.offset[idx] = 0;
+            }
+        } while(idx);
 
-        data = next;
-        next = strchr(data, ',');
-        *next++ = '\0';
+    } else {
 
-        if(parseDecimal(&grbl_data.offset.y, data))
-            grbl_data.changed.offset = true;
+        uint_fast8_t idx = 0;
 
-        if(parseDecimal(&grbl_data.offset.z, next))
-            grbl_data.changed.offset = true;
+        do {
+            if(parseDecimal(&grbl_data.offset.values[idx], &fixed.offset[idx], &data))
+                grbl_data.changed.offset = true;
+        } while(++idx < N_AXIS_MAX && nextValue(&data));
     }
 
     grbl_data.changed.await_wco_ok = grbl_data.awaitWCO;
+
+    return data;
 }
 
-static void parseOverrides (char *data)
+static char *parseOverrides (char *data)
 {
-    char *next;
     uint32_t value;
 
-    next = strchr(data, ',');
-    *next++ = '\0';
-
     value = grbl_data.override.feed_rate;
-    if(parseUint(&value, data)) {
+    if(parseUint(&value, &data)) {
         grbl_data.changed.feed_override = true;
         grbl_data.override.feed_rate = (override_t)value;
     }
 
-    data = next;
-    next = strchr(data, ',');
-    *next++ = '\0';
-
-    value = grbl_data.override.rapid_rate;
-    if(parseUint(&value, data)) {
-        grbl_data.changed.rapid_override = true;
-        grbl_data.override.rapid_rate = (override_t)value;
+    if(nextValue(&data)) {
+        value = grbl_data.override.rapid_rate;
+        if(parseUint(&value, &data)) {
+            grbl_data.changed.rapid_override = true;
+            grbl_data.override.rapid_rate = (override_t)value;
+        }
     }
 
-    value = grbl_data.override.spindle_rpm;
-    if(parseUint(&value, data)) {
-        grbl_data.changed.rpm_override = true;
-        grbl_data.override.spindle_rpm = (override_t)value;
+    if(nextValue(&data)) {
+        value = grbl_data.override.spindle_rpm;
+        if(parseUint(&value, &data)) {
+            grbl_data.changed.rpm_override = true;
+            grbl_data.override.spindle_rpm = (override_t)value;
+        }
     }
+
+    return data;
 }
 
-static void parseFeedSpeed (char *data)
+static char *parseFeedSpeed (char *data, bool speed)
 {
-    char *next;
-
-    next = strchr(data, ',');
-    *next++ = '\0';
-
-    if(parseDecimal(&grbl_data.feed_rate, data))
+    if(parseDecimal(&grbl_data.feed_rate, &fixed.feed_rate, &data))
         grbl_data.changed.feed = true;
 
-    data = next;
-    if((next = strchr(data, ',')))
-        *next++ = '\0';
+    if(speed && nextValue(&data)) {
 
-    if(parseDecimal(&grbl_data.spindle.rpm_programmed, data))
-        grbl_data.changed.rpm = true;
+        if(parseDecimal(&grbl_data.spindle.rpm_programmed, &fixed.rpm_programmed, &data))
+            grbl_data.changed.rpm = true;
+
+        if(nextValue(&data) && parseDecimal(&grbl_data.spindle.rpm_actual, &fixed.rpm_actual, &data))
+            grbl_data.changed.rpm = true;
+    }
 
-    if(next && parseDecimal(&grbl_data.spindle.rpm_actual, next))
-        grbl_data.changed.rpm = true;
+    return data;
 }
 
-static void parseData (char *block)
+static char *parseAccessories (char *data)
 {
-    static char buf[MAX_BLOCK_LENGTH];
+    grbl_data.spindle.state.on =
+    grbl_data.spindle.state.ccw =
+    grbl_data.coolant.flood =
+    grbl_data.coolant.mist = false;
+    grbl_data.changed.leds = true;
 
-    uint32_t c;
-    bool pins = true;
-    char *line = &buf[0];
+    while(!isFieldEnd(*data)) {
 
-    if((ack_received = !strcmp(block, "ok"))) {
-        grbl_data.changed.await_ack = false;
-        grblClearError(); // TODO: grbl needs to be fixed for continuing to process from input buffer after error...
-        if(grbl_data.alarm)
-            grblClearAlarm();
-        return;
+        switch(*data++) {
+
+            case 'M':
+                grbl_data.coolant.mist = true;
+                break;
+
+            case 'F':
+                grbl_data.coolant.flood = true;
+                break;
+
+            case 'S':
+                grbl_data.spindle.state.ccw = false;
+                grbl_data.spindle.state.on = true;
+                break;
+
+            case 'C':
+               grbl_data.spindle.state.ccw = true;
+               grbl_data.spindle.state.on = true;
+               break;
+        }
     }
 
-    if(block[0] == '<' || block[0] =='[') // strip last character from long messages
-        block[strlen(block) - 1] = '\0';
+    return data;
+}
 
-    strncpy(line, block, MAX_BLOCK_LENGTH);
-    line[MAX_BLOCK_LENGTH - 1] = '\0';
+// Handles the state field of a real-time report, returns a pointer to the end of the field
+static char *parseReportState (char *data)
+{
+    bool changed;
 
-    if(line[0] == '<') {
-        pins = false;
-        line = strtok(&line[1], "|");
+    report.pins = report.positions = report.line_number = report.buffers = false;
 
-        if(line) {
+    data = parseState(data, &grbl_data.grbl, &changed);
 
-            if(grblParseState(line, &grbl_data.grbl)) {
+    if(changed) {
 
-                grbl_data.changed.state = true;
+        grbl_data.changed.state = true;
 
-                setLeds(grbl_data.grbl.state);
+        setLeds(grbl_data.grbl.state);
 
-                if(!(grbl_data.grbl.state == Alarm || grbl_data.grbl.state == Tool) && grbl_data.message[0] != '\0')
-                    grblClearMessage();
-            }
+        if(!(grbl_data.grbl.state == Alarm || grbl_data.grbl.state == Tool) && grbl_data.message[0] != '\0')
+            grblClearMessage();
+    }
 
-            if(grbl_data.alarm && grbl_data.grbl.state != Alarm)
-                grblClearAlarm();
+    if(grbl_data.alarm && grbl_data.grbl.state != Alarm)
+        grblClearAlarm();
 
-            line = strtok(NULL, "|");
-        }
+    return data;
+}
 
-        while(line) {
+// Handles a single real-time report field, dispatched on its first characters.
+// Returns a pointer to where parsing stopped, unknown fields are left unparsed.
+static char *parseReportField (char *data)
+{
+    bool changed;
+
+    switch(*data) {
 
-            if(!strncmp(line, "WPos:", 5)) {
+        case 'W':
+            if(data[1] == 'P' && data[2] == 'o' && data[3] == 's' && data[4] == ':') { // WPos:
                 if(!grbl_data.useWPos) {
                     grbl_data.useWPos = true;
                     grbl_data.changed.offset = true;
                 }
-                parsePositions(line + 5);
+                report.positions = true;
+                data = parsePositions(data + 5);
+            } else if(data[1] == 'C' && data[2] == 'O' && data[3] == ':') // WCO:
+                data = parseOffsets(data + 4);
+            break;
+
+        case 'L':
+            if(data[1] == 'n' && data[2] == ':') {              // Ln:
+                data += 3;
+                report.line_number = true;
+                grbl_data.changed.line_number = parseUint(&grbl_data.line_number, &data);
+            }
+            break;
 
-            } else if(!strncmp(line, "MPos:", 5)) {
+        case 'M':
+            if(data[1] == 'P' && data[2] == 'o' && data[3] == 's' && data[4] == ':') { // MPos:
                 if(grbl_data.useWPos) {
                     grbl_data.useWPos = false;
                     grbl_data.changed.offset = true;
                 }
-                parsePositions(line + 5);
-
-            } else if(!strncmp(line, "FS:", 3))
-                parseFeedSpeed(line + 3);
+                report.positions = true;
+                data = parsePositions(data + 5);
+            } else if(data[1] == 'P' && data[2] == 'G' && data[3] == ':') { // MPG:
+                if((grbl_data.changed.mpg = grbl_data.mpgMode != (data[4] == '1'))) {
+                    grbl_data.mpgMode = !grbl_data.mpgMode;
+                    grbl_event.on_line_received = parseData;
+                }
+            }
+            break;
 
-            else if(!strncmp(line, "WCO:", 4))
-                parseOffsets(line + 4);
+        case 'F':
+            if(data[1] == 'S' && data[2] == ':')                // FS:
+                data = parseFeedSpeed(data + 3, true);
+            else if(data[1] == ':')                             // F:
+                data = parseFeedSpeed(data + 2, false);
+            break;
 
-            else if(!strncmp(line, "Pn:", 3)) {
-                pins = true;
-                if((grbl_data.changed.pins = (strcmp(grbl_data.pins, line + 3) != 0)));
-                    strcpy(grbl_data.pins, line + 3);
+        case 'P':
+            if(data[1] == 'n' && data[2] == ':') {              // Pn:
+                report.pins = true;
+                data = parseString(grbl_data.pins, sizeof(grbl_data.pins), data + 3, &changed);
+                grbl_data.changed.pins = changed;
+            }
+            break;
 
-            } else if(!strncmp(line, "D:", 2)) {
-                grbl_data.xModeDiameter = line[2] == '1';
+        case 'D':
+            if(data[1] == ':') {                                // D:
+                grbl_data.xModeDiameter = data[2] == '1';
                 grbl_data.changed.xmode = true;
+            }
+            break;
 
-            } else if(!strncmp(line, "A:", 2)) {
-
-                line = &line[2];
-                grbl_data.spindle.state.on =
-                grbl_data.spindle.state.ccw =
-                grbl_data.coolant.flood =
-                grbl_data.coolant.mist = false;
-                grbl_data.changed.leds = true;
-
-                while((c = *line++)) {
-                    switch(c) {
-
-                        case 'M':
-                            grbl_data.coolant.mist = true;
-                            break;
-
-                        case 'F':
-                            grbl_data.coolant.flood = true;
-                            break;
-
-                        case 'S':
-                            grbl_data.spindle.state.ccw = false;
-                            grbl_data.spindle.state.on = true;
-                            break;
-
-                        case 'C':
-                           grbl_data.spindle.state.ccw = true;
-                           grbl_data.spindle.state.on = true;
-                           break;
-                    }
-                }
-
-            } else if(!strncmp(line, "Ov:", 3))
-                parseOverrides(line + 3);
-
-            else if(!strcmp(line, "AR") || !strncmp(line, "AR:", 3)) {
+        case 'A':
+            if(data[1] == ':')                                  // A:
+                data = parseAccessories(data + 2);
+            else if(data[1] == 'R') {                           // AR, AR:
                 grbl_data.autoReporting = true;
-                if(line[2] == ':')
-                    grbl_data.changed.auto_reporting = parseUint(&grbl_data.autoReportingInterval, &line[3]);
-                else {
+                if(data[2] == ':') {
+                    data += 3;
+                    grbl_data.changed.auto_reporting = parseUint(&grbl_data.autoReportingInterval, &data);
+                } else {
                     grbl_data.changed.auto_reporting = grbl_data.autoReportingInterval != 0;
                     grbl_data.autoReportingInterval = 0;
                 }
-            } else if(!strncmp(line, "MPG:", 4)) {
-                if((grbl_data.changed.mpg = grbl_data.mpgMode != (line[4] == '1'))) {
-                    grbl_data.mpgMode = !grbl_data.mpgMode;
-                    grbl_event.on_line_received = parseData;
+            }
+            break;
+
+        case 'B':
+            if(data[1] == 'f' && data[2] == ':') {              // Bf:<planner blocks free>,<rx bytes free>
+                uint32_t blocks = 0, rx = 0;
+                data += 3;
+                parseUint(&blocks, &data);
+                if(*data == ',') {
+                    data++;
+                    parseUint(&rx, &data);
+                    // free space is never more than the buffer size so the largest seen is a safe estimate of it
+                    if(rx > grbl_info.rx_buffer_size)
+                        grbl_info.rx_buffer_size = rx;
                 }
+                grbl_data.buffers.reported = report.buffers = true;
+                grbl_data.buffers.planner = (uint16_t)blocks;
+                grbl_data.buffers.rx = (uint16_t)rx;
+                grbl_data.changed.buffers = true;
+            }
+            break;
 
-            } else if(!strncmp(line, "SD:", 3)) {
-                if((grbl_data.changed.message = !!strcmp(grbl_data.message, line + 3)))
-                    strncpy(grbl_data.message, line + 3, sizeof(grbl_data.message) - 1);
+        case 'O':
+            if(data[1] == 'v' && data[2] == ':')                // Ov:
+                data = parseOverrides(data + 3);
+            break;
+
+        case 'S':
+            if(data[1] == 'D' && data[2] == ':') {              // SD:
+                data = parseString(grbl_data.message, sizeof(grbl_data.message), data + 3, &changed);
+                grbl_data.changed.message = changed;
+            }
+            break;
 
-            } else if(!strncmp(line, "TLR:", 4)) {
-                if((grbl_data.changed.tlo_reference = grbl_data.tloReferenced != (line[4] == '1'))) {
+        case 'T':
+            if(data[1] == 'L' && data[2] == 'R' && data[3] == ':') { // TLR:
+                if((grbl_data.changed.tlo_reference = grbl_data.tloReferenced != (data[4] == '1'))) {
                     grbl_data.tloReferenced = !grbl_data.tloReferenced;
                     grbl_data.changed.leds = true;
                     grbl_data.leds.tlo_refd = grbl_data.changed.tlo_reference;
                 }
             }
+            break;
+    }
 
-            line = strtok(NULL, "|");
-        }
+    return data;
+}
+
+static void parseReportEnd (void)
+{
+    // Fields left out of a report are cleared, changes flagged by previous reports are kept until consumed
+    if(!report.pins && grbl_data.pins[0] != '\0') {
+        grbl_data.pins[0] = '\0';
+        grbl_data.changed.pins = true;
+    }
 
-        if(!pins && (grbl_data.changed.pins = (grbl_data.pins[0] != '\0')))
-            grbl_data.pins[0] = '\0';
+    if(!report.line_number && grbl_data.line_number != 0) {
+        grbl_data.line_number = 0;
+        grbl_data.changed.line_number = true;
+    }
+
+    grbl_data.buffers.reported = report.buffers;
 
-    } else if(line[0] == '[') {
-        line++;
-        if(!strncmp(line, "GC:", 3)) {
+    link_stats.reports++;
+
+    if(status_request.pending) {
+        status_request.pending = false;
+        if((link_stats.latency = lcd_systicks() - status_request.sent) > link_stats.latency_max)
+            link_stats.latency_max = link_stats.latency;
+    }
+}
+
+// Walks a complete real-time report in place
+static void parseStatusReport (char *data)
+{
+    data = parseReportState(data);
 
-            line = strtok(&line[3], " ");
+    while(true) {
 
-            while(line) {
+        while(!isFieldEnd(*data)) // skip unknown fields and trailing data
+            data++;
 
-                if(!strncmp(line, "F", 1) && parseDecimal(&grbl_data.feed_rate, line + 1))
+        if(*data != '|')
+            break;
+
+        data = parseReportField(data + 1);
+    }
+
+    parseReportEnd();
+}
+
+static inline bool isWordEnd (char c)
+{
+    return c == ' ' || c == ']' || c == '\0';
+}
+
+// Walks a [GC:...] parser state report in place, words are separated by spaces
+static void parseParserState (char *data)
+{
+    while(*data && *data != ']') {
+
+        switch(*data++) {
+
+            case 'F':
+                if(parseDecimal(&grbl_data.feed_rate, &fixed.feed_rate, &data))
                     grbl_data.changed.feed = true;
+                break;
 
-                if(!strncmp(line, "S", 1) && parseDecimal(&grbl_data.spindle.rpm_programmed, line + 1))
+            case 'S':
+                if(parseDecimal(&grbl_data.spindle.rpm_programmed, &fixed.rpm_programmed, &data))
                     grbl_data.changed.rpm = true;
+                break;
 
-                if(!strncmp(line, "G7", 2)) {
+            case 'G':
+                if(data[0] == '7' && isWordEnd(data[1])) {
                     grbl_data.xModeDiameter = true;
                     grbl_data.changed.xmode = true;
-                }
-
-                if(!strncmp(line, "G8", 2)) {
+                } else if(data[0] == '8' && isWordEnd(data[1])) {
                     grbl_data.xModeDiameter = false;
                     grbl_data.changed.xmode = true;
-                }
-
-                if(!strncmp(line, "G90", 3) && !grbl_data.absDistance) {
+                } else if(data[0] == '9' && data[1] == '0' && isWordEnd(data[2]) && !grbl_data.absDistance) {
                     grbl_data.absDistance = true;
                     grbl_data.changed.dist = true;
-                }
-
-                if(!strncmp(line, "G91", 3) && grbl_data.absDistance) {
+                } else if(data[0] == '9' && data[1] == '1' && isWordEnd(data[2]) && grbl_data.absDistance) {
                     grbl_data.absDistance = false;
                     grbl_data.changed.dist = true;
                 }
+                break;
 
-                if(!strncmp(line, "M5", 2)) {
-                    if(grbl_data.spindle.state.on)
-                        grbl_data.changed.leds = true;
-                    grbl_data.spindle.state.on = grbl_data.leds.spindle = false;
-                } else if(!strncmp(line, "M3", 2)) {
-                    if(!grbl_data.spindle.state.on || grbl_data.spindle.state.ccw)
-                        grbl_data.changed.leds = true;
-                    grbl_data.spindle.state.on = grbl_data.leds.spindle = true;
-                    grbl_data.spindle.state.ccw = false;
-                } else if(!strncmp(line, "M4", 2)) {
-                    if(!grbl_data.spindle.state.on || !grbl_data.spindle.state.ccw)
-                        grbl_data.changed.leds = true;
-                    grbl_data.spindle.state.on = grbl_data.leds.spindle = true;
-                    grbl_data.spindle.state.ccw = true;
-                }
+            case 'M':
+                if(isWordEnd(data[1])) switch(data[0]) {
 
-                if(!strncmp(line, "M9", 2)) {
-                    if(grbl_data.coolant.mist || grbl_data.coolant.flood)
-                        grbl_data.changed.leds = true;
-                    grbl_data.coolant.mist = grbl_data.leds.mist = false;
-                    grbl_data.coolant.flood = grbl_data.leds.flood = false;
-                } else {
-                    if(!strncmp(line, "M7", 2)) {
+                    case '5':
+                        if(grbl_data.spindle.state.on)
+                            grbl_data.changed.leds = true;
+                        grbl_data.spindle.state.on = grbl_data.leds.spindle = false;
+                        break;
+
+                    case '3':
+                        if(!grbl_data.spindle.state.on || grbl_data.spindle.state.ccw)
+                            grbl_data.changed.leds = true;
+                        grbl_data.spindle.state.on = grbl_data.leds.spindle = true;
+                        grbl_data.spindle.state.ccw = false;
+                        break;
+
+                    case '4':
+                        if(!grbl_data.spindle.state.on || !grbl_data.spindle.state.ccw)
+                            grbl_data.changed.leds = true;
+                        grbl_data.spindle.state.on = grbl_data.leds.spindle = true;
+                        grbl_data.spindle.state.ccw = true;
+                        break;
+
+                    case '9':
+                        if(grbl_data.coolant.mist || grbl_data.coolant.flood)
+                            grbl_data.changed.leds = true;
+                        grbl_data.coolant.mist = grbl_data.leds.mist = false;
+                        grbl_data.coolant.flood = grbl_data.leds.flood = false;
+                        break;
+
+                    case '7':
                         if(!grbl_data.coolant.mist)
                             grbl_data.changed.leds = true;
                         grbl_data.coolant.mist = grbl_data.leds.mist = true;
-                    }
-                    if(!strncmp(line, "M8", 2)) {
+                        break;
+
+                    case '8':
                         if(!grbl_data.coolant.flood)
                             grbl_data.changed.leds = true;
                         grbl_data.coolant.flood = grbl_data.leds.flood = true;
-                    }
+                        break;
                 }
-                line = strtok(NULL, " ");
-            }
-        } else if(!strncmp(line, "MSG:", 4)) {
-            grbl_data.changed.message = true;
-            strncpy(grbl_data.message, line + 4, 250);
+                break;
         }
-    } else if(!strncmp(line, "error:", 6)) {
-        grbl_data.error = (uint8_t)atoi(line + 6);
-        grbl_data.changed.error = true;
-    } else if(!strncmp(line, "ALARM:", 6)) {
-        grbl_data.alarm = (uint8_t)atoi(line + 6);
-        grbl_data.changed.alarm = true;
-    } else if(!strncmp(line, "Grbl", 4)) {
-        grbl_data.changed.reset = true;
-        grblClearError();
-        grblClearAlarm();
-        grblClearMessage();
-        grbl_event.on_line_received = parseData;
+
+        while(!isWordEnd(*data))
+            data++;
+
+        if(*data == ' ')
+            data++;
+    }
+}
+
+static void parseData (char *block)
+{
+    if((ack_received = !strcmp(block, "ok"))) {
+        bool awaited = grbl_data.changed.await_ack;
+        grbl_data.changed.await_ack = false;
+        grblClearError(); // TODO: grbl needs to be fixed for continuing to process from input buffer after error...
+        if(grbl_data.alarm)
+            grblClearAlarm();
+        if(grblTransmitCallback && !awaited) // acknowledges a block sent by the transmit callback owner
+            grblTransmitCallback(true, &grbl_data);
+        else if(grbl_event.on_report_received && !awaited)
+            grbl_event.on_report_received(block);
+        return;
+    }
+
+    switch(block[0]) {
+
+        case '<':
+            parseStatusReport(block + 1);
+            break;
+
+        case '[':
+            if(!strncmp(block + 1, "GC:", 3))
+                parseParserState(block + 4);
+
+            else if(!strncmp(block + 1, "MSG:", 4)) {
+
+                char *msg = grbl_data.message, *data = block + 5;
+
+                while(*data && msg < &grbl_data.message[250])
+                    *msg++ = *data++;
+
+                if(msg > grbl_data.message && *data == '\0' && msg[-1] == ']') // strip closing bracket
+                    msg--;
+
+                *msg = '\0';
+                grbl_data.changed.message = true;
+            }
+            break;
+
+        default:
+            if(!strncmp(block, "error:", 6)) {
+                uint32_t code = 0;
+                block += 6;
+                parseUint(&code, &block);
+                grbl_data.error = (uint8_t)code;
+                grbl_data.changed.error = true;
+            } else if(!strncmp(block, "ALARM:", 6)) {
+                uint32_t code = 0;
+                block += 6;
+                parseUint(&code, &block);
+                grbl_data.alarm = (uint8_t)code;
+                grbl_data.changed.alarm = true;
+            } else if(!strncmp(block, "Grbl", 4)) {
+                settings_cache.valid = settings.is_loaded = false;
+                grbl_data.changed.reset = true;
+                grblClearError();
+                grblClearAlarm();
+                grblClearMessage();
+                grbl_event.on_line_received = parseData;
+            }
+            break;
     }
 
     if(grbl_event.on_report_received && !grbl_data.changed.await_ack)
@@ -614,55 +969,152 @@ void grblClearMessage (void)
     grbl_data.message[0] = '\0';
 }
 
-void grblSendSerial (char *line)
+// Setting writes ($n=value) invalidate the settings cache
+void grblSendSerial (const char *line)
 {
+    if(line[0] == '$' && isDigit(line[1]) && strchr(line, '='))
+        settings_cache.valid = settings.is_loaded = false;
+
     serial_writeLn(line);
 }
 
 bool grblParseState (char *data, grbl_t *grbl)
 {
-    bool changed = false;
-    uint_fast8_t len, substate = 0;
-    char *s = strchr(data, ':');
+    bool changed;
 
-    if(s) {
-        *s++ = '\0';
-        substate = atoi(s);
-    }
+    parseState(data, grbl, &changed);
 
-    len = strlen(data);
+    return changed;
+}
 
-    if(len < sizeof(grbl->state_text) && strncmp(grbl->state_text, data, len)) {
-        uint_fast8_t state = 0;
-        while(state < NUMSTATES) {
-            if((changed = !strcmp(data, grblState[state]))) {
-                grbl->state = (grbl_state_t)state;
-                grbl->substate = substate;
-                grbl->state_color = grblStateColor[state];
-                strcpy(grbl->state_text, data);
-                break;
-            }
-            state++;
-        }
+// FNV-1a
+static uint32_t checksum (uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *byte = (const uint8_t *)data;
+
+    while(size--)
+        hash = (hash ^ *byte++) * 16777619UL;
+
+    return hash;
+}
+
+// Calculated from the setting values, not from the string pool which may hold stale strings
+static uint32_t settingsChecksum (void)
+{
+    uint_fast16_t idx;
+    uint32_t hash = CHECKSUM_INIT;
+
+    for(idx = 0; idx < settings_cache.count; idx++) {
+
+        grbl_setting_t *setting = &settings_cache.table[idx];
+
+        hash = checksum(hash, &setting->id, sizeof(setting->id));
+        hash = checksum(hash, &setting->type, sizeof(setting->type));
+
+        if(setting->type == SettingValue_String)
+            hash = checksum(hash, &settings_cache.pool[setting->string], strlen(&settings_cache.pool[setting->string]));
+        else
+            hash = checksum(hash, &setting->integer, sizeof(setting->integer));
     }
 
-    if(!changed && grbl->substate != substate) {
-        changed = true;
-        grbl->substate = substate;
+    return hash;
+}
+
+static void loadSnapshot (void)
+{
+    const grbl_setting_t *setting;
+
+    snapshot.checked = true;
+
+    if(!(nvs_read(&nvs_buffer, sizeof(snapshot_t)) &&
+          nvs_buffer.magic == SNAPSHOT_MAGIC &&
+           nvs_buffer.size == sizeof(snapshot_t) &&
+            nvs_buffer.count > 0 && nvs_buffer.count <= GRBL_SETTINGS_MAX &&
+             nvs_buffer.pool_used > 0 && nvs_buffer.pool_used <= GRBL_SETTINGS_POOL_SIZE &&
+              nvs_buffer.checksum == checksum(CHECKSUM_INIT, &nvs_buffer, offsetof(snapshot_t, checksum))))
+        return;
+
+    memcpy(&grbl_info, &nvs_buffer.info, sizeof(grbl_info_t));
+    memcpy(&settings, &nvs_buffer.settings, sizeof(settings_t));
+    memcpy(settings_cache.table, nvs_buffer.table, sizeof(settings_cache.table));
+    memcpy(settings_cache.pool, nvs_buffer.pool, sizeof(settings_cache.pool));
+    settings_cache.count = nvs_buffer.count;
+    settings_cache.pool_used = nvs_buffer.pool_used;
+    settings_cache.valid = settings.is_loaded = true;
+
+    grbl_info.is_loaded = false; // set when verified by a $I response
+
+    snapshot.verify = true;
+    snapshot.info_checksum = nvs_buffer.info_checksum;
+    snapshot.settings_checksum = nvs_buffer.settings_checksum;
+
+    if((setting = grblGetSetting(Setting_EnableLegacyRTCommands)))
+        setGrblLegacyMode(setting->integer != 0);
+}
+
+// Called when settings has been loaded or updated, the snapshot is only to be written if the $I response or settings changed
+static void saveSnapshot (void)
+{
+    snapshot.save = info_checksum != 0 && (info_checksum != snapshot.info_checksum || settingsChecksum() != snapshot.settings_checksum);
+}
+
+// Writes the snapshot if changed, returns true if written. Blocks for some tens of milliseconds
+// while non-volatile storage is written, to be called when idle and not from a serial data handler.
+bool grblStoreSnapshot (void)
+{
+    uint32_t settings_checksum;
+
+    if(!(snapshot.save && settings_cache.valid && grbl_event.on_line_received == parseData))
+        return false;
+
+    snapshot.save = false;
+    settings_checksum = settingsChecksum();
+
+    memset(&nvs_buffer, 0, sizeof(snapshot_t));
+
+    nvs_buffer.magic = SNAPSHOT_MAGIC;
+    nvs_buffer.size = sizeof(snapshot_t);
+    nvs_buffer.info_checksum = info_checksum;
+    nvs_buffer.settings_checksum = settings_checksum;
+    memcpy(&nvs_buffer.info, &grbl_info, sizeof(grbl_info_t));
+    memcpy(&nvs_buffer.settings, &settings, sizeof(settings_t));
+    memcpy(nvs_buffer.table, settings_cache.table, sizeof(settings_cache.table));
+    memcpy(nvs_buffer.pool, settings_cache.pool, sizeof(settings_cache.pool));
+    nvs_buffer.count = (uint16_t)settings_cache.count;
+    nvs_buffer.pool_used = (uint16_t)settings_cache.pool_used;
+    nvs_buffer.checksum = checksum(CHECKSUM_INIT, &nvs_buffer, offsetof(snapshot_t, checksum));
+
+    if(nvs_write(&nvs_buffer, sizeof(snapshot_t))) {
+        snapshot.info_checksum = info_checksum;
+        snapshot.settings_checksum = settings_checksum;
     }
 
-    return changed;
+    return true;
 }
 
 static void parse_info (char *line)
 {
     if(!strcmp(line, "ok")) {
         grbl_event.on_line_received = parseData;
+        info_checksum = info_hash;
+        if(snapshot.verify) {
+            snapshot.verify = false;
+            if(info_checksum != snapshot.info_checksum) // controller firmware or configuration changed, settings has to be fetched again
+                settings_cache.valid = settings.is_loaded = false;
+            else
+                grbl_event.on_info_received = NULL; // the snapshot has already been returned
+        }
         if(grbl_event.on_info_received) {
             grbl_event.on_info_received(&grbl_info);
             grbl_event.on_info_received = NULL;
         }
-    } else if(!strncmp(line, "[VER:", 5)) {
+        return;
+    }
+
+    if(*line == '[' && strncmp(line, "[MSG:", 5))
+        info_hash = checksum(info_hash, line, strlen(line));
+
+    if(!strncmp(line, "[VER:", 5)) {
         grbl_info.is_loaded = true;
         if((line = strchr(line + 5, ':')))
             line[strlen(line) - 1] = '\0';
@@ -670,6 +1122,45 @@ static void parse_info (char *line)
             strncpy(grbl_info.device, line, MAX_STORED_LINE_LENGTH - 1);
             grbl_info.device[MAX_STORED_LINE_LENGTH - 1] = '\0';
         }
+    } else if(!strncmp(line, "[AXS:", 5)) { // [AXS:<n_axis>:<axis letters>]
+
+        uint32_t n_axis = 0;
+        uint_fast8_t idx = 0;
+        bool changed = false;
+
+        line += 5;
+        if(parseUint(&n_axis, &line) && n_axis > 0 && *line++ == ':') {
+
+            while(idx < N_AXIS_MAX && idx < n_axis && *line != ']' && *line != '\0') {
+                if(grbl_data.axis_letters[idx] != *line) {
+                    grbl_data.axis_letters[idx] = *line;
+                    changed = true;
+                }
+                idx++;
+                line++;
+            }
+
+            if(changed)
+                grbl_data.changed.axes = true;
+
+            setAxisCount(n_axis > N_AXIS_MAX ? N_AXIS_MAX : n_axis);
+        }
+    } else if(!strncmp(line, "[OPT:", 5)) { // [OPT:<flags>,<planner blocks>,<rx buffer size>...]
+
+        uint32_t value = 0;
+
+        if((line = strchr(line + 5, ','))) {
+            line++;
+            parseUint(&value, &line);
+            grbl_info.planner_blocks = value;
+            if(*line == ',') {
+                line++;
+                value = 0;
+                parseUint(&value, &line);
+                if(value)
+                    grbl_info.rx_buffer_size = value;
+            }
+        }
     } else if(!strncmp(line, "[NEWOPT:", 8)) {
 
         line[strlen(line) - 1] = '\0';
@@ -688,14 +1179,26 @@ static void parse_info (char *line)
         parseData(line);
 }
 
+// A snapshot from non-volatile storage is returned right away, it is then verified against
+// the $I response when in MPG mode. grbl_info.is_loaded is set when the info is from a $I response.
+// Settings are only fetched again if the $I response differs from the one the snapshot was taken with.
 void grblGetInfo (grbl_info_received_ptr on_info_received)
 {
+    if(!snapshot.checked)
+        loadSnapshot();
+
+    if(snapshot.verify && grbl_event.on_line_received != parse_info && on_info_received) {
+        snapshot.on_info_received = on_info_received;
+        on_info_received(&grbl_info);
+    }
+
     if(grbl_data.mpgMode && grbl_event.on_line_received == parseData) {
-        grbl_event.on_info_received = on_info_received;
+        grbl_event.on_info_received = snapshot.verify ? snapshot.on_info_received : on_info_received;
         grbl_event.on_line_received = parse_info;
+        info_hash = CHECKSUM_INIT;
         serial_RxCancel();
         serial_writeLn("$I");
-    } else if (on_info_received)
+    } else if (on_info_received && !snapshot.verify)
         on_info_received(&grbl_info); // return default values
 }
 
@@ -704,23 +1207,210 @@ grbl_options_t grblGetOptions (void)
     return grbl_info.options;
 }
 
-static void parse_settings (char *line)
+uint_fast16_t grblGetRxBufferSize (void)
+{
+    return grbl_info.rx_buffer_size ? grbl_info.rx_buffer_size : GRBL_RX_BUFFER_SIZE;
+}
+
+// Sends a real-time status request, the time to the report answering it is recorded as the link latency
+void grblRequestStatus (char c)
+{
+    uint32_t now = lcd_systicks();
+
+    if(!status_request.pending || now - status_request.sent > STATUS_REQUEST_TIMEOUT) {
+        status_request.pending = true;
+        status_request.sent = now;
+    }
+
+    link_stats.requests++;
+
+    serial_putC(c);
+}
+
+grbl_link_stats_t *grblGetLinkStats (void)
+{
+    return &link_stats;
+}
+
+// The cache is updated from each $$ response, settings not reported are removed when it is complete
+static void fetchSettings (void)
+{
+    settings_cache.valid = false;
+    settings_cache.pass++;
+    grbl_event.on_line_received = parse_settings;
+    serial_RxCancel();
+    serial_writeLn("$$");
+}
+
+// Binary search for a setting, returns its index or the index it is to be inserted at
+static uint_fast16_t settingIndex (uint16_t id, bool *found)
+{
+    uint_fast16_t lo = 0, hi = settings_cache.count, mid;
+
+    while(lo < hi) {
+        mid = (lo + hi) >> 1;
+        if(settings_cache.table[mid].id == id) {
+            *found = true;
+            return mid;
+        }
+        if(settings_cache.table[mid].id < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    *found = false;
+
+    return lo;
+}
+
+static setting_value_type_t settingType (const char *value)
+{
+    bool digits = false, decimal = false;
+
+    if(*value == '-')
+        value++;
+
+    while(isDigit(*value) || (*value == '.' && !decimal)) {
+        if(*value == '.')
+            decimal = true;
+        else
+            digits = true;
+        value++;
+    }
+
+    return digits && *value == '\0' ? (decimal ? SettingValue_Decimal : SettingValue_Integer) : SettingValue_String;
+}
+
+static float settingDecimal (const grbl_setting_t *setting)
+{
+    return setting->type == SettingValue_Decimal ? setting->decimal : (setting->type == SettingValue_Integer ? (float)setting->integer : 0.0f);
+}
+
+// Adds or updates a setting, the change callback is called if the value differs from the cached one.
+// Returns NULL if the table is full.
+// Moves the strings still referenced to the start of the pool, in pool order so none is
+// overwritten before moved.
+static void compactPool (void)
+{
+    uint_fast16_t idx, from = 0, used = 1;
+    size_t len;
+    grbl_setting_t *lowest;
+
+    do {
+        lowest = NULL;
+        for(idx = 0; idx < settings_cache.count; idx++) {
+            grbl_setting_t *setting = &settings_cache.table[idx];
+            if(setting->type == SettingValue_String && setting->string > from && (lowest == NULL || setting->string < lowest->string))
+                lowest = setting;
+        }
+        if(lowest) {
+            from = lowest->string;
+            len = strlen(&settings_cache.pool[from]) + 1;
+            memmove(&settings_cache.pool[used], &settings_cache.pool[from], len);
+            lowest->string = used;
+            used += len;
+        }
+    } while(lowest);
+
+    settings_cache.pool_used = used;
+}
+
+// Removes the settings not reported in the last $$ response
+static void sweepSettings (void)
 {
-    static uint_fast16_t setting = 0;
+    uint_fast16_t idx, count = 0;
+
+    for(idx = 0; idx < settings_cache.count; idx++) {
+
+        grbl_setting_t *setting = &settings_cache.table[idx];
+
+        if(setting->pass == settings_cache.pass)
+            settings_cache.table[count++] = *setting;
+        else if(grbl_event.on_setting_changed) {
+            grbl_setting_t removed = { .id = setting->id, .pass = setting->pass, .type = SettingValue_Removed };
+            grbl_event.on_setting_changed(&removed);
+        }
+    }
+
+    settings_cache.count = count;
+}
+
+static grbl_setting_t *storeSetting (uint16_t id, const char *value)
+{
+    bool found, changed;
+    grbl_setting_t entry = { .id = id, .pass = settings_cache.pass, .type = settingType(value) };
+    uint_fast16_t idx = settingIndex(id, &found);
+    grbl_setting_t *setting = &settings_cache.table[idx];
+
+    if(!found && settings_cache.count == GRBL_SETTINGS_MAX)
+        return NULL;
+
+    switch(entry.type) {
+
+        case SettingValue_Integer:
+            entry.integer = (int32_t)strtol(value, NULL, 10);
+            changed = !found || setting->type != entry.type || setting->integer != entry.integer;
+            break;
 
+        case SettingValue_Decimal:
+            entry.decimal = strtof(value, NULL);
+            changed = !found || setting->type != entry.type || setting->decimal != entry.decimal;
+            break;
+
+        default:
+            if((changed = !found || setting->type != entry.type || strcmp(&settings_cache.pool[setting->string], value))) {
+                size_t len = strlen(value) + 1;
+                if(len > 1 && settings_cache.pool_used + len > GRBL_SETTINGS_POOL_SIZE)
+                    compactPool(); // reclaim space left by replaced values
+                if(len > 1 && settings_cache.pool_used + len <= GRBL_SETTINGS_POOL_SIZE) {
+                    entry.string = settings_cache.pool_used;
+                    memcpy(&settings_cache.pool[entry.string], value, len);
+                    settings_cache.pool_used += len;
+                } else
+                    entry.string = 0; // empty or no room
+            } else
+                entry.string = setting->string;
+            break;
+    }
+
+    if(!found) {
+        memmove(setting + 1, setting, (settings_cache.count - idx) * sizeof(grbl_setting_t));
+        settings_cache.count++;
+    }
+
+    *setting = entry;
+
+    if(changed && grbl_event.on_setting_changed)
+        grbl_event.on_setting_changed(setting);
+
+    return setting;
+}
+
+static void parse_settings (char *line)
+{
     if(!strcmp(line, "ok")) {
         grbl_event.on_line_received = parseData;
-        settings.is_loaded = setting > 0;
+        sweepSettings();
+        settings_cache.valid = true;
+        if((settings.is_loaded = settings_cache.count > 0))
+            saveSnapshot();
         if(grbl_event.on_settings_received) {
             grbl_event.on_settings_received(&settings);
             grbl_event.on_settings_received = NULL;
         }
-    } else if(line[0] == '$' && strchr(line, '=')) {
+    } else if(line[0] == '$' && isDigit(line[1])) {
+
+        uint32_t setting = 0;
+        grbl_setting_t *entry;
+        char *data = line + 1;
+
+        parseUint(&setting, &data);
+
+        if(*data++ != '=')
+            return;
 
-        line = strtok(&line[1], "=");
-        setting = atoi(line);
-        line = strtok(NULL, "=");
-        float value = atof(line);
+        float value = (entry = storeSetting((uint16_t)setting, data)) ? settingDecimal(entry) : strtof(data, NULL);
 
         switch((setting_type_t)setting) {
 
@@ -775,57 +1465,111 @@ static void parse_settings (char *line)
         parseData(line);
 }
 
+// Returns the cached settings if valid, else they are fetched with $$
 void grblGetSettings (grbl_settings_received_ptr on_settings_received)
 {
-    if(grbl_data.mpgMode && grbl_event.on_line_received == parseData) {
+    if(settings_cache.valid) {
+        if(on_settings_received)
+            on_settings_received(&settings);
+    } else if(grbl_data.mpgMode && grbl_event.on_line_received == parseData) {
         grbl_event.on_settings_received = on_settings_received;
-        grbl_event.on_line_received = parse_settings;
-        serial_RxCancel();
-        serial_writeLn("$$");
-    } else if (on_settings_received)
+        fetchSettings();
+    } else if(grbl_event.on_line_received == parse_settings && on_settings_received)
+        grbl_event.on_settings_received = on_settings_received; // notified when the settings being fetched are received
+    else if (on_settings_received)
         on_settings_received(&settings); // return default values
 }
 
+const grbl_setting_t *grblGetSetting (uint16_t id)
+{
+    bool found;
+    uint_fast16_t idx;
+
+    if(!settings_cache.valid)
+        return NULL;
+
+    idx = settingIndex(id, &found);
+
+    return found ? &settings_cache.table[idx] : NULL;
+}
+
+bool grblGetSettingDecimal (uint16_t id, float *value)
+{
+    const grbl_setting_t *setting = grblGetSetting(id);
+
+    if(setting && setting->type != SettingValue_String)
+        *value = settingDecimal(setting);
+
+    return setting && setting->type != SettingValue_String;
+}
+
+const char *grblGetSettingString (const grbl_setting_t *setting)
+{
+    return setting && setting->type == SettingValue_String ? &settings_cache.pool[setting->string] : "";
+}
+
+// Called when a setting write sent by grblSendSerial() has been answered, the cache invalidated
+// by it is valid again. The cached value is updated if value is not NULL, pass NULL if rejected.
+void grblUpdateSetting (uint16_t id, const char *value)
+{
+    if(settings_cache.count == 0)
+        return;
+
+    if(value)
+        storeSetting(id, value);
+
+    settings_cache.valid = settings.is_loaded = true;
+
+    if(value)
+        saveSnapshot();
+}
+
+void grblSetSettingChangedCallback (grbl_setting_changed_ptr fn)
+{
+    grbl_event.on_setting_changed = fn;
+}
+
 static void parse_sd_files (char *line)
 {
     if(!strcmp(line, "ok")) {
         grbl_event.on_line_received = parseData;
+        sd_files.complete = true;
+        grblSortSDFiles(&sd_files, sd_files.sort);
         if(grbl_event.on_sd_files_received) {
             grbl_event.on_sd_files_received(&sd_files);
             grbl_event.on_sd_files_received = NULL;
         }
-    } else if(!strncmp(line, "[FILE:", 6)) {
+    } else if(!strncmp(line, "[FILE:", 6)) { // [FILE:<name>|SIZE:<length>]
 
-        sd_file_t *file, *next = sd_files.files;
-        
-        if((file = (sd_file_t *)malloc(sizeof(sd_file_t)))) {
-        
-            char *size;
-            
-            line += 6;
-            if((size = strstr(line, "|SIZE:"))) {
-                *size = '\0';
-                size += 6;
-            }
+        char *name = line + 6, *data = name;
+        uint32_t length = 0;
+        size_t len;
 
-            strcpy(file->name, line);
-            file->next = NULL;
+        while(*data && *data != '|' && *data != ']')
+            data++;
 
-            if(size && ((line = strchr(size, '|')) || (line = strchr(size, ']')))) {
-                *line = '\0';
-                file->length = (uint32_t)atoi(size);
-            } else
-                file->length = 0;
-
-            if(sd_files.files == NULL)
-                sd_files.files = file;
-            else {
-                while(next->next)
-                    next = next->next;
-                next->next= file;    
-            }
-            sd_files.num_files++;
-        }    
+        len = data - name;
+
+        if(!strncmp(data, "|SIZE:", 6)) {
+            data += 6;
+            parseUint(&length, &data);
+        }
+
+        if(sd_files.num_entries < SD_FILES_MAX && sd_files.names_used + len + 1 <= SD_NAMES_POOL_SIZE) {
+
+            sd_file_t *file = &sd_files.entry[sd_files.num_entries];
+
+            file->name = &sd_files.names[sd_files.names_used];
+            file->length = length;
+            memcpy(&sd_files.names[sd_files.names_used], name, len);
+            sd_files.names[sd_files.names_used + len] = '\0';
+            sd_files.names_used += len + 1;
+            sd_files.index[sd_files.num_files++] = sd_files.num_entries++;
+            // Pass on each page as it arrives so the first entries can be shown while the rest are listed
+            if(grbl_event.on_sd_files_received && sd_files.num_entries % SD_FILES_PAGE == 0)
+                grbl_event.on_sd_files_received(&sd_files);
+        } else
+            sd_files.truncated = true;
     } else
         parseData(line);
 }
@@ -833,19 +1577,87 @@ static void parse_sd_files (char *line)
 void grblGetSDFiles (grbl_sd_files_received_ptr on_sd_files_received)
 {
     if(grbl_data.mpgMode && grbl_info.options.sd_card && grbl_event.on_line_received == parseData) {
-        sd_file_t *file ;
-        while(sd_files.files) {
-            file = sd_files.files->next;
-            free(sd_files.files);
-            sd_files.files = file;
-        }
-        sd_files.num_files = 0;
+        sd_files.num_files = sd_files.num_entries = sd_files.names_used = 0;
+        sd_files.truncated = sd_files.complete = false;
         grbl_event.on_sd_files_received = on_sd_files_received;
         grbl_event.on_line_received = parse_sd_files;
         serial_RxCancel();
         serial_writeLn("$F");
-    } else if (on_settings_received)
-        on_sd_files_received(&sd_files); // return default values
+    } else if (on_sd_files_received)
+        on_sd_files_received(&sd_files); // return last listing
+}
+
+sd_file_t *grblGetSDFile (sd_files_t *files, uint_fast16_t idx)
+{
+    return files && idx < files->num_files ? &files->entry[files->index[idx]] : NULL;
+}
+
+static sd_files_t *sort_files;
+
+static int compareSDFiles (const void *a, const void *b)
+{
+    const sd_file_t *file_a = &sort_files->entry[*(const uint16_t *)a], *file_b = &sort_files->entry[*(const uint16_t *)b];
+
+    switch(sort_files->sort) {
+
+        case SDSort_Name:
+            return strcasecmp(file_a->name, file_b->name);
+
+        case SDSort_Length:
+            return file_a->length < file_b->length ? -1 : (file_a->length > file_b->length ? 1 : 0);
+
+        default:
+            return *(const uint16_t *)a - *(const uint16_t *)b; // received order
+    }
+}
+
+void grblSortSDFiles (sd_files_t *files, sd_sort_t sort)
+{
+    files->sort = sort;
+    sort_files = files;
+
+    qsort(files->index, files->num_files, sizeof(uint16_t), compareSDFiles);
+}
+
+// Rebuilds the view with the files matching one of a comma separated list of extensions,
+// e.g. "nc,ngc,tap". A NULL or empty list selects all files. Returns the number of files in the view.
+uint_fast16_t grblFilterSDFiles (sd_files_t *files, const char *extensions)
+{
+    uint_fast16_t idx;
+
+    files->num_files = 0;
+
+    for(idx = 0; idx < files->num_entries; idx++) {
+
+        bool match = extensions == NULL || *extensions == '\0';
+        const char *ext = strrchr(files->entry[idx].name, '.'), *list = extensions;
+
+        if(!match && ext++) {
+
+            size_t ext_len = strlen(ext);
+
+            while(*list && !match) {
+
+                size_t len = 0;
+
+                while(list[len] && list[len] != ',')
+                    len++;
+
+                match = len == ext_len && !strncasecmp(ext, list, len);
+
+                list += len;
+                if(*list == ',')
+                    list++;
+            }
+        }
+
+        if(match)
+            files->index[files->num_files++] = (uint16_t)idx;
+    }
+
+    grblSortSDFiles(files, files->sort);
+
+    return files->num_files;
 }
 
 static void await_ack (char *line)
@@ -859,7 +1671,7 @@ bool grblAwaitACK (const char *command, uint_fast16_t timeout_ms)
     grbl_data.changed.await_ack = true;
 //    grbl_event.on_line_received = await_ack;
     serial_RxCancel();
-    serial_writeLn(command);
+    grblSendSerial(command);
 
     timeout_ms += lcd_systicks();
     while(!ack_received && lcd_systicks() <= timeout_ms)
@@ -871,16 +1683,57 @@ bool grblAwaitACK (const char *command, uint_fast16_t timeout_ms)
     return ack_received;
 }
 
+// Real-time reports are parsed field by field as the characters arrive, only the field being
+// received is buffered. After the state field the block holds the report opener and the state,
+// e.g. "<Idle", for callbacks inspecting it. Other lines are buffered and handed to the current
+// line handler when complete. Complete lines are taken in one go if the serial driver keeps
+// a line index, characters are only read one by one for lines still being received.
 void grblPollSerial (void)
 {
     static int_fast16_t c;
-    static uint_fast16_t char_counter = 0;
+    static uint_fast16_t char_counter = 0, field = 0;
+    static bool streaming = false;
+
+    while(char_counter == 0 && (c = serial_getLn(grbl_data.block, MAX_BLOCK_LENGTH)) != SERIAL_NO_DATA) {
+        if(c > 0)
+            grbl_event.on_line_received(grbl_data.block);
+    }
 
     while((c = serial_getC()) != SERIAL_NO_DATA) {
 
-        if(c == 0x18) //ASCII_CAN
+        if(c == 0x18) { //ASCII_CAN
             char_counter = 0;
-        else if(((c == '\n') || (c == '\r'))) { // End of line reached
+            streaming = false;
+        } else if(streaming && (c == '|' || c == '>' || c == '\n' || c == '\r')) { // End of report field reached
+
+            grbl_data.block[char_counter] = '\0';
+
+            if(field == 0) {
+                parseReportState(grbl_data.block + 1);
+                field = char_counter < MAX_BLOCK_LENGTH - 1 ? char_counter + 1 : char_counter;
+            } else
+                parseReportField(grbl_data.block + field);
+
+            char_counter = field;
+
+            if(c != '|') {
+                streaming = false;
+                char_counter = 0;
+                parseReportEnd();
+            }
+
+            // Changes are notified as soon as a field ends, but not before the positions are known
+            // since handlers act on the state and position together. The transmit callback is
+            // notified once per report as it is also called for responses to the blocks sent.
+            if(grbl_event.on_report_received && !grbl_data.changed.await_ack &&
+                (!streaming || (report.positions && grbl_data.changed.flags && !grblTransmitCallback)))
+                grbl_event.on_report_received(grbl_data.block);
+
+        } else if(c == '<' && char_counter == 0) { // Start of real-time report
+            streaming = true;
+            field = 0;
+            grbl_data.block[char_counter++] = (char)c;
+        } else if(((c == '\n') || (c == '\r'))) { // End of line reached
 
             grbl_data.block[char_counter] = '\0';
             
@@ -895,8 +1748,12 @@ void grblPollSerial (void)
 }
 
 __attribute__((weak)) int16_t serial_getC (void) { return SERIAL_NO_DATA; }
+__attribute__((weak)) int16_t serial_getLn (char *line, uint_fast16_t size) { return SERIAL_NO_DATA; }
+__attribute__((weak)) bool serial_putC (const char c) { return false; }
 __attribute__((weak)) void serial_writeLn (const char *data) {}
 __attribute__((weak)) void serial_RxCancel (void);
+__attribute__((weak)) bool nvs_read (void *data, size_t size) { return false; }
+__attribute__((weak)) bool nvs_write (const void *data, size_t size) { return false; }
 
 #endif // PARSER_SERIAL_ENABLE
 
@@ -997,7 +1854,7 @@ void grblPollI2C (void)
 
             case MachineMsg_WorkOffset:
                 grbl_data.changed.offset = true;
-                memcpy(&grbl_data.offset, (machine_coords_t *)packet->msg, sizeof(grbl_data.offset));
+                memcpy(&grbl_data.offset, (machine_coords_t *)packet->msg, sizeof(machine_coords_t));
                 break;
 
             case MachineMsg_Overrides:
@@ -1023,7 +1880,7 @@ void grblPollI2C (void)
         }
     }
 
-    idx = grbl_data.n_axis;
+    idx = grbl_data.n_axis > 4 ? 4 : grbl_data.n_axis; // the I2C interface carries up to four axes
 
     do {
         idx--;
@@ -49,6 +49,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define SERIAL_NO_DATA -1
 #define MAX_BLOCK_LENGTH 256
+#define FIXED_DECIMALS 4
+#define FIXED_SCALE 10000
 
 //#define PARSER_SERIAL_ENABLE
 
@@ -57,6 +59,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define X_AXIS 0
 #define Y_AXIS 1
 #define Z_AXIS 2
+#define A_AXIS 3
+#define B_AXIS 4
+#define C_AXIS 5
+
+#define N_AXIS_MAX 6
 
 #define MAX_BLOCK_LENGTH 256
 
@@ -112,9 +119,9 @@ typedef union {
 } leds_t;
 
 typedef union {
-    uint32_t flags;
+    uint64_t flags;
     struct {
-        uint32_t xpos           :1,
+        uint64_t xpos           :1,
                  ypos           :1,
                  zpos           :1,
                  apos           :1,
@@ -145,19 +152,43 @@ typedef union {
                  jog_mode       :1,
                  tlo_reference  :1,
                  auto_reporting :1,
-                 unassigned     :1;
+                 axes           :1, // number of axes or axis letters changed
+                 buffers        :1, // Bf: received, set for every report carrying it
+                 line_number    :1,
+                 unassigned     :30;
     };
 } changes_t;
 
+typedef struct {
+    bool reported;      // Bf: is enabled in the real-time report
+    uint16_t planner;   // free planner blocks
+    uint16_t rx;        // free bytes in the RX buffer
+} buffer_state_t;
+
+typedef union {
+    float values[N_AXIS_MAX];
+    struct {
+        float x;
+        float y;
+        float z;
+        float a;
+        float b;
+        float c;
+    };
+} axes_coords_t;
+
 typedef struct {
     uint8_t n_axis;
+    char axis_letters[N_AXIS_MAX + 1];
     grbl_t grbl;
-    machine_coords_t position;
-    machine_coords_t offset;
+    axes_coords_t position;
+    axes_coords_t offset;
     spindle_data_t spindle;
     coolant_state_t coolant;
     overrides_t override;
     float feed_rate;
+    buffer_state_t buffers;
+    uint32_t line_number;   // from Ln:, 0 if not reported
     bool useWPos;
     bool awaitWCO;
     bool absDistance;
@@ -191,21 +222,42 @@ typedef union {
     };
 } grbl_options_t;
 
+#define GRBL_RX_BUFFER_SIZE 128     // assumed when the controller does not report its RX buffer size
+
 typedef struct {
     bool is_loaded;
     grbl_options_t options;
+    uint_fast16_t planner_blocks;   // from [OPT:], 0 if not reported
+    uint_fast16_t rx_buffer_size;   // from [OPT:] or the largest free space reported by Bf:, 0 if not known
     char device[MAX_STORED_LINE_LENGTH];
 } grbl_info_t;
 
-typedef struct sd_file {
+#define SD_FILES_MAX 256            // number of files kept from a $F listing
+#define SD_NAMES_POOL_SIZE 8192     // size of pool for the file names
+#define SD_FILES_PAGE 8             // files received between partial listing callbacks
+
+typedef enum {
+    SDSort_None = 0,    // in received order
+    SDSort_Name,
+    SDSort_Length
+} sd_sort_t;
+
+typedef struct {
     uint32_t length;
-    char name[MAX_STORED_LINE_LENGTH];
-    struct sd_file *next;
+    const char *name;   // in the names pool
 } sd_file_t;
 
+// Files are stored in the order received, index[] holds the sorted and filtered view of them
 typedef struct {
-    uint_fast16_t num_files;
-    sd_file_t *files;
+    uint_fast16_t num_files;    // number of files in the view
+    uint_fast16_t num_entries;  // number of files received
+    uint_fast16_t names_used;
+    bool truncated;             // the listing did not fit
+    bool complete;              // false for the partial listings passed on while receiving
+    sd_sort_t sort;
+    sd_file_t entry[SD_FILES_MAX];
+    uint16_t index[SD_FILES_MAX];
+    char names[SD_NAMES_POOL_SIZE];
 } sd_files_t;
 
 typedef struct {
@@ -232,7 +284,37 @@ typedef struct {
     jog_config_t jog_config;
 } settings_t;
 
+#define GRBL_SETTINGS_MAX 320       // number of $$ settings cached
+#define GRBL_SETTINGS_POOL_SIZE 512 // size of string pool for string settings
+#define GRBL_SNAPSHOT_SIZE_MAX 4096 // non-volatile storage available for the $I and $$ snapshot, one RP2040 flash sector
+
+typedef enum {
+    SettingValue_Integer = 0,
+    SettingValue_Decimal,
+    SettingValue_String,
+    SettingValue_Removed // passed to the setting changed callback for settings no longer reported
+} setting_value_type_t;
+
+typedef struct {
+    uint16_t id;
+    uint8_t pass;        // $$ response the setting was last reported in
+    setting_value_type_t type;
+    union {
+        int32_t integer;
+        float decimal;
+        uint16_t string; // offset into the string pool, use grblGetSettingString()
+    };
+} grbl_setting_t;
+
+typedef struct {
+    uint32_t requests;      // status requests sent by grblRequestStatus()
+    uint32_t reports;       // real-time reports received
+    uint32_t latency;       // ms from the oldest unanswered status request to the end of the next report
+    uint32_t latency_max;
+} grbl_link_stats_t;
+
 typedef void (*grbl_settings_received_ptr)(settings_t *settings);
+typedef void (*grbl_setting_changed_ptr)(const grbl_setting_t *setting);
 typedef void (*grbl_info_received_ptr)(grbl_info_t *info);
 typedef void (*grbl_parser_state_received_ptr)(grbl_data_t *info);
 typedef void (*grbl_sd_files_received_ptr)(sd_files_t *files);
@@ -243,16 +325,28 @@ void grblSerialFlush (void);
 void grblClearAlarm (void);
 void grblClearError (void);
 void grblClearMessage (void);
-void grblSendSerial (char *line);
+void grblSendSerial (const char *line);
 bool grblParseState (char *state, grbl_t *grbl);
 bool grblAwaitACK (const char *command, uint_fast16_t timeout_ms);
 bool grblIsMPGActive (void);
 
 void grblGetInfo (grbl_info_received_ptr on_info_received);
 void grblGetSettings (grbl_settings_received_ptr on_settings_received);
+const grbl_setting_t *grblGetSetting (uint16_t id);
+bool grblGetSettingDecimal (uint16_t id, float *value);
+const char *grblGetSettingString (const grbl_setting_t *setting);
+void grblUpdateSetting (uint16_t id, const char *value);
+bool grblStoreSnapshot (void);
+void grblSetSettingChangedCallback (grbl_setting_changed_ptr fn);
 void grblGetParserState (grbl_parser_state_received_ptr on_parser_state_received);
 void grblGetSDFiles (grbl_sd_files_received_ptr on_sd_files_received);
+sd_file_t *grblGetSDFile (sd_files_t *files, uint_fast16_t idx);
+void grblSortSDFiles (sd_files_t *files, sd_sort_t sort);
+uint_fast16_t grblFilterSDFiles (sd_files_t *files, const char *extensions);
 grbl_options_t grblGetOptions (void);
+uint_fast16_t grblGetRxBufferSize (void);
+void grblRequestStatus (char c);
+grbl_link_stats_t *grblGetLinkStats (void);
 
 void setGrblLegacyMode (bool on);
 char mapRTC2Legacy (char c);
@@ -281,8 +375,12 @@ uint32_t lcd_systicks (void);
 #ifdef PARSER_SERIAL_ENABLE
 
 extern int16_t serial_getC (void);
+extern int16_t serial_getLn (char *line, uint_fast16_t size);
+extern bool serial_putC (const char c);
 extern void serial_writeLn (const char *data);
 extern void serial_RxCancel (void);
+extern bool nvs_read (void *data, size_t size);
+extern bool nvs_write (const void *data, size_t size);
 
 #endif
 
@@ -45,10 +45,14 @@ interface_t interface = {0};
 // Serial interface
 __attribute__((weak)) void serial_init (void) {}
 __attribute__((weak)) int16_t serial_getC (void) { return -1; }
+__attribute__((weak)) int16_t serial_getLn (char *line, uint_fast16_t size) { return -1; }
 __attribute__((weak)) void serial_writeS (void) {}
 __attribute__((weak)) void serial_writeLn (const char *data) {}
 __attribute__((weak)) bool serial_putC (const char c) { return false; }
+__attribute__((weak)) bool serial_sendLn (const char *data, bool blocking) { serial_writeLn(data); return true; }
+__attribute__((weak)) bool serial_txBusy (const char *data) { return false; }
 __attribute__((weak)) void serial_RxCancel (void);
+__attribute__((weak)) const serial_counters_t *serial_getCounters (void) { static serial_counters_t counters = {0}; return &counters; }
 
 __attribute__((weak)) bool keypad_isKeydown (void) { return false; }
 __attribute__((weak)) void keypad_setFwd (bool on) {};
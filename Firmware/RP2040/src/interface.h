@@ -74,6 +74,15 @@ typedef struct {
     mpg_axis_t x, y, z;
 } mpg_t;
 
+typedef struct {
+    uint32_t bytes_in;
+    uint32_t bytes_out;
+    uint32_t lines_in;
+    uint32_t overflows;         // received data dropped as the buffer was full
+    uint32_t tx_drops;          // lines or real-time commands not sent as the transmit queue was full
+    uint32_t framing_errors;
+} serial_counters_t;
+
 typedef void (*on_keyclick_ptr)(bool keydown, char key);
 typedef bool (*on_serial_block_ptr)(void);
 typedef void (*on_jogModeChanged_ptr)(jogmode_t jogMode);
@@ -95,9 +104,13 @@ extern void hal_init (void);
 
 extern void serial_init (void);
 extern int16_t serial_getC (void);
+extern int16_t serial_getLn (char *line, uint_fast16_t size);
 extern bool serial_putC (const char c);
 extern void serial_writeLn (const char *data);
+extern bool serial_sendLn (const char *data, bool blocking);
+extern bool serial_txBusy (const char *data);
 extern void serial_RxCancel (void);
+extern const serial_counters_t *serial_getCounters (void);
 
 extern bool keypad_isKeydown (void);
 extern void keypad_setFwd (bool on);
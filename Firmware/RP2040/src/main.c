@@ -49,6 +49,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "canvas/dro.h"
 #include "grbl/parser.h"
 #include "interface.h"
+#ifdef LCD_FILL_BENCHMARK
+#include "fonts.h"
+#endif
 
 extern bool flashKeypadController (void);
 
@@ -72,6 +75,19 @@ void main (void)
 
     screen = getDisplayDescriptor();
 
+#ifdef LCD_FILL_BENCHMARK
+    {
+        char msg[32];
+        uint32_t us = lcd_fillBenchmark(10);
+
+        sprintf(msg, "Fill: %lu us", us);
+        drawString(font_freepixel_9x17, 10, 30, msg, false);
+        sprintf(msg, "%lu kpixels/s", (uint32_t)screen->Width * screen->Height * 1000UL / us);
+        drawString(font_freepixel_9x17, 10, 50, msg, false);
+        delay(5000);
+    }
+#endif
+
     BOOTShowCanvas(screen);
 
     navigator_setLimits(0, screen->Height);